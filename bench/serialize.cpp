@@ -0,0 +1,188 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include <erl/reflect>
+#include <erl/_impl/net/message/buffer.hpp>
+#include <erl/_impl/net/message/reader.hpp>
+
+namespace {
+std::atomic<std::size_t> allocations{0};
+}
+
+// count every allocation made through operator new
+// HybridBuffer allocates with malloc directly, its heap spills are reported separately
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (auto* ptr = std::malloc(size); ptr != nullptr) {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+namespace {
+enum class Color : std::uint8_t { red, green, blue };
+
+struct Point {
+  std::int32_t x;
+  std::int32_t y;
+  std::int32_t z;
+};
+
+struct Particle {
+  Point position;
+  Point velocity;
+  Color color;
+  bool alive;
+};
+
+using Shape = std::variant<std::int64_t, Point, std::string>;
+
+template <typename T>
+void do_not_optimize(T const& value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct Result {
+  double ns_per_op;
+  double bytes_per_second;
+  double allocations_per_op;
+  double spills_per_op;
+};
+
+template <typename F>
+Result measure(std::size_t bytes_per_op, F&& fnc) {
+  constexpr std::size_t warmup     = 1'000;
+  constexpr std::size_t iterations = 100'000;
+
+  for (std::size_t idx = 0; idx < warmup; ++idx) {
+    fnc();
+  }
+
+  std::size_t spills = 0;
+  auto before        = allocations.load(std::memory_order_relaxed);
+  auto start         = std::chrono::steady_clock::now();
+  for (std::size_t idx = 0; idx < iterations; ++idx) {
+    spills += fnc() ? 1 : 0;
+  }
+  auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  auto after   = allocations.load(std::memory_order_relaxed);
+
+  return {.ns_per_op          = elapsed / iterations,
+          .bytes_per_second   = double(bytes_per_op) * iterations / (elapsed * 1e-9),
+          .allocations_per_op = double(after - before) / iterations,
+          .spills_per_op      = double(spills) / iterations};
+}
+
+void report(std::string_view name, std::string_view buffer, std::string_view operation, Result const& result) {
+  std::println("{:<22} {:<13} {:<12} {:>10.1f} ns/op {:>10.1f} MB/s {:>6.2f} allocs/op {:>5.2f} spills/op",
+               name,
+               buffer,
+               operation,
+               result.ns_per_op,
+               result.bytes_per_second / 1e6,
+               result.allocations_per_op,
+               result.spills_per_op);
+}
+
+template <typename Buffer>
+bool spilled(Buffer const& buffer) {
+  if constexpr (requires { buffer.is_heap(); }) {
+    return buffer.is_heap();
+  } else {
+    return false;
+  }
+}
+
+template <typename Buffer, typename T>
+void run(std::string_view name, std::string_view buffer_name, T const& value) {
+  auto reference = Buffer{};
+  erl::serialize(value, reference);
+  auto data  = reference.finalize();
+  auto bytes = data.size();
+
+  report(name, buffer_name, "serialize", measure(bytes, [&] {
+           // reserve exactly once, like RPCProtocol does
+           auto buffer = Buffer{};
+           buffer.reserve(erl::serialized_size(value));
+           erl::serialize(value, buffer);
+           do_not_optimize(buffer);
+           return spilled(buffer);
+         }));
+
+  report(name, buffer_name, "deserialize", measure(bytes, [&] {
+           auto reader = erl::message::MessageView{data};
+           auto result = erl::deserialize<T>(reader);
+           do_not_optimize(result);
+           return false;
+         }));
+
+  auto target = std::vector<char>(bytes);
+  report(name, buffer_name, "memcpy", measure(bytes, [&] {
+           std::memcpy(target.data(), data.data(), bytes);
+           do_not_optimize(target);
+           return false;
+         }));
+}
+
+template <typename Buffer>
+void run_all(std::string_view buffer_name) {
+  auto numbers = std::vector<std::int32_t>(4096);
+  for (std::size_t idx = 0; idx < numbers.size(); ++idx) {
+    numbers[idx] = static_cast<std::int32_t>(idx * 7);
+  }
+
+  auto strings = std::vector<std::string>{};
+  for (std::size_t idx = 0; idx < 256; ++idx) {
+    strings.push_back("entry number " + std::to_string(idx));
+  }
+
+  auto unordered = std::unordered_map<std::int32_t, std::string>{};
+  auto ordered   = std::map<std::int32_t, std::string>{};
+  for (std::int32_t idx = 0; idx < 256; ++idx) {
+    unordered.emplace(idx, "value " + std::to_string(idx));
+    ordered.emplace(idx, "value " + std::to_string(idx));
+  }
+
+  auto particle = Particle{
+      .position = {1, 2, 3},
+      .velocity = {-1, 0, 1},
+      .color    = Color::green,
+      .alive    = true
+  };
+
+  run<Buffer>("int", buffer_name, std::int32_t{42});
+  run<Buffer>("enum", buffer_name, Color::blue);
+  run<Buffer>("nested aggregate", buffer_name, particle);
+  run<Buffer>("variant<Point>", buffer_name, Shape{Point{4, 5, 6}});
+  run<Buffer>("variant<string>", buffer_name, Shape{std::string{"a short string"}});
+  run<Buffer>("vector<int>", buffer_name, numbers);
+  run<Buffer>("vector<string>", buffer_name, strings);
+  run<Buffer>("unordered_map", buffer_name, unordered);
+  run<Buffer>("map", buffer_name, ordered);
+}
+}  // namespace
+
+int main() {
+  run_all<erl::message::HeapBuffer>("HeapBuffer");
+  run_all<erl::message::HybridBuffer<>>("HybridBuffer");
+}
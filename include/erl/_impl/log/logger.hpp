@@ -41,7 +41,7 @@ class LoggingService {
 
 public:
   using policy       = rpc::Annotated;
-  using message_type = erl::message::HybridBuffer<58>;
+  using message_type = rpc::SizedBuffer<LoggingService>;
   using protocol     = rpc::RPCProtocol<message_type>;
 
   [[= rpc::callback]] void spawn(timestamp_t timestamp, std::uint64_t thread);
@@ -51,12 +51,15 @@ public:
   [[= rpc::callback]] void add_sink(Sink* sink);
   [[= rpc::callback]] void remove_sink(Sink* sink);
 
+  // prelude and a few short arguments fit into the inline buffer
   template <typename... Args>
-  [[= rpc::handler(^^LoggingService::handle_print)]] static auto print(erl::logging::Severity severity,
-                                                                       erl::logging::formatter_type formatter,
-                                                                       Args&&... args) {
-    auto message   = message_type{};
-    serialize(make_prelude(severity, formatter), message);
+  [[= rpc::handler(^^LoggingService::handle_print)]] [[= rpc::size_hint(erl::fixed_size_of<LoggingEvent> + 32)]]
+  static auto print(erl::logging::Severity severity, erl::logging::formatter_type formatter, Args&&... args) {
+    auto prelude = make_prelude(severity, formatter);
+    auto message = message_type{};
+    // formatted arguments are rarely fixed size, allocate once instead of growing
+    message.reserve(erl::serialized_size(prelude) + (erl::serialized_size(args) + ... + 0UZ));
+    serialize(prelude, message);
     (serialize(std::forward<Args>(args), message), ...);
     return message;
   }
@@ -0,0 +1,160 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* Traffic capture
+
+Capturing<C> wraps a client and records every message it sends or receives:
+
+  [magic "ERLCAP01"]
+  [time (8 bytes)] [direction (1 byte)] [size (4 bytes)] [message] ...
+
+Times are nanoseconds since the capture was opened, all integers are stored in
+native byte order. Captures are read back with read_capture and can be replayed
+against a service with rpc::replay.
+*/
+
+namespace erl::net {
+struct CaptureError : std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+enum class Direction : std::uint8_t { sent, received };
+
+namespace _capture_impl {
+constexpr inline char magic[8] = {'E', 'R', 'L', 'C', 'A', 'P', '0', '1'};
+}
+
+// capture file shared by any number of clients
+class Capture {
+  using clock = std::chrono::steady_clock;
+
+  std::ofstream out;
+  clock::time_point start = clock::now();
+  std::mutex lock;
+
+  void write(void const* data, std::size_t size) { out.write(static_cast<char const*>(data), std::streamsize(size)); }
+
+public:
+  explicit Capture(std::string const& path) : out(path, std::ios::binary | std::ios::trunc) {
+    if (!out) {
+      throw CaptureError("Could not open " + path);
+    }
+    write(_capture_impl::magic, sizeof(_capture_impl::magic));
+  }
+
+  void record(Direction direction, std::span<char const> message) {
+    auto time = std::int64_t{std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count()};
+    auto size = static_cast<std::uint32_t>(message.size());
+
+    auto guard = std::lock_guard{lock};
+    write(&time, sizeof(time));
+    write(&direction, sizeof(direction));
+    write(&size, sizeof(size));
+    write(message.data(), message.size());
+  }
+
+  void flush() {
+    auto guard = std::lock_guard{lock};
+    out.flush();
+  }
+};
+
+struct CapturedMessage {
+  std::chrono::nanoseconds time;
+  Direction direction;
+  std::vector<char> data;
+};
+
+inline std::vector<CapturedMessage> read_capture(std::string const& path) {
+  auto in = std::ifstream(path, std::ios::binary);
+  if (!in) {
+    throw CaptureError("Could not open " + path);
+  }
+
+  char magic[sizeof(_capture_impl::magic)];
+  if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, _capture_impl::magic, sizeof(magic)) != 0) {
+    throw CaptureError("Not a capture file");
+  }
+
+  auto messages = std::vector<CapturedMessage>{};
+  std::int64_t time;
+  while (in.read(reinterpret_cast<char*>(&time), sizeof(time))) {
+    auto direction = Direction{};
+    std::uint32_t size;
+    if (!in.read(reinterpret_cast<char*>(&direction), sizeof(direction)) ||
+        !in.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+      throw CaptureError("Truncated capture file");
+    }
+
+    auto& message = messages.emplace_back(std::chrono::nanoseconds{time}, direction, std::vector<char>(size));
+    if (!in.read(message.data.data(), size)) {
+      throw CaptureError("Truncated capture file");
+    }
+  }
+  return messages;
+}
+
+// records all traffic of the wrapped client
+// message clients such as QueueClient record every message in both directions
+// stream clients such as tcp::Client record one message per send, their reads are partial and not recorded
+// the goodbye message sent by kill is not recorded
+template <typename C>
+struct Capturing : C {
+  Capture* capture;
+
+  // extra arguments such as the lane of LaneClient are passed through
+  template <typename... Options>
+  void send(auto const& message, Options&&... options)
+    requires requires(C& client) { client.send(message, std::forward<Options>(options)...); }
+  {
+    capture->record(Direction::sent, std::span<char const>{message});
+    C::send(message, std::forward<Options>(options)...);
+  }
+
+  auto recv()
+    requires requires(C& client) { client.recv(); }
+  {
+    auto message = C::recv();
+    record(message);
+    return message;
+  }
+
+  template <typename Clock, typename Duration>
+  auto recv(std::stop_token const& token, std::chrono::time_point<Clock, Duration> deadline)
+    requires requires(C& client) { client.recv(token, deadline); }
+  {
+    auto message = C::recv(token, deadline);
+    record(message);
+    return message;
+  }
+
+  template <typename T>
+  bool try_recv(T& target)
+    requires requires(C& client) { client.try_recv(target); }
+  {
+    if (!C::try_recv(target)) {
+      return false;
+    }
+    record(target);
+    return true;
+  }
+
+private:
+  void record(auto const& message) {
+    // empty messages signal timeouts or shutdown
+    if (auto data = std::span<char const>{message}; !data.empty()) {
+      capture->record(Direction::received, data);
+    }
+  }
+};
+}  // namespace erl::net
@@ -0,0 +1,109 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <utility>
+
+namespace erl::net {
+// marks a single source of a ReadySet as ready
+struct Signal {
+  std::atomic<std::uint64_t>* word;
+  std::uint64_t bit;
+
+  void raise() const { word->fetch_or(bit, std::memory_order_release); }
+};
+
+// readiness of N sources, one bit per source
+template <std::size_t N>
+class ReadySet {
+  constexpr static std::size_t bits       = 64;
+  constexpr static std::size_t word_count = (N + bits - 1) / bits;
+
+  std::array<std::atomic<std::uint64_t>, word_count> words{};
+
+public:
+  Signal signal_of(std::size_t idx) { return {&words[idx / bits], std::uint64_t{1} << (idx % bits)}; }
+
+  void mark(std::size_t idx) { signal_of(idx).raise(); }
+
+  // clears all ready bits and calls fnc with the index of every source that was ready
+  // returns false if no source was ready
+  template <typename F>
+  bool consume(F&& fnc) {
+    bool any = false;
+    for (std::size_t word = 0; word < word_count; ++word) {
+      if (words[word].load(std::memory_order_relaxed) == 0) {
+        continue;
+      }
+
+      auto pending = words[word].exchange(0, std::memory_order_acquire);
+      any |= pending != 0;
+      while (pending != 0) {
+        auto bit = static_cast<std::size_t>(std::countr_zero(pending));
+        pending &= pending - 1;
+        fnc(word * bits + bit);
+      }
+    }
+    return any;
+  }
+};
+
+// raises its signal after every message, so a HubServer knows where to look
+template <typename C>
+struct SignalingClient : C {
+  Signal signal;
+
+  void send(auto const& message) {
+    C::send(message);
+    signal.raise();
+  }
+
+  void kill() {
+    C::kill();
+    signal.raise();
+  }
+};
+
+// serves N connections from a single thread
+// every connection needs try_recv, replies are sent on the connection the request arrived on
+template <typename C, std::size_t N>
+struct HubServer {
+  ReadySet<N>* ready;
+  std::array<C, N> connections;
+
+  template <typename T>
+  void run(T&& service) {
+    std::bitset<N> closed{};
+    while (!closed.all()) {
+      auto progress = ready->consume([&](std::size_t idx) {
+        auto& connection = connections[idx];
+        auto message     = decltype(connection.recv()){};
+        if (closed.test(idx) || !connection.try_recv(message)) {
+          return;
+        }
+
+        if (std::span<char const>{message}.empty()) {
+          closed.set(idx);
+          return;
+        }
+
+        connection.handle(service, std::span<char const>{message});
+        // one message per round keeps busy connections from starving the others
+        ready->mark(idx);
+      });
+
+      if (!progress) {
+        std::this_thread::yield();
+      }
+    }
+  }
+};
+
+template <typename C, std::size_t N>
+HubServer(ReadySet<N>*, std::array<C, N>) -> HubServer<C, N>;
+}  // namespace erl::net
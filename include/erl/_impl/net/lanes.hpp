@@ -0,0 +1,111 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <thread>
+
+#include "queue.hpp"
+
+/* Priority lanes
+
+Requests are queued on one lane per priority level. Servers always take the
+request from the highest non-empty lane, except when a lower lane has been
+passed over `patience` times in a row - then that lane is served once, so
+bulk traffic cannot starve completely.
+
+Replies are not ordered like the requests they answer. Clients therefore never
+stop waiting for a reply, a skipped reply could belong to a later call.
+Deadlines of rpc::CallScope are still sent along and enforced by the server.
+*/
+
+namespace erl::net {
+// client side, sends on the lane of the called method
+// R is void for fire-and-forget lanes
+template <typename Q, std::size_t Lanes, typename R = void>
+struct LaneClient {
+  std::array<Q*, Lanes> lanes;
+  R* replies = nullptr;
+
+  void send(auto const& message, std::uint8_t priority) {
+    lanes[std::min<std::size_t>(priority, Lanes - 1)]->push(message);
+  }
+
+  void send(auto const& message) { send(message, 0); }
+
+  auto recv()
+    requires(is_queue<R>)
+  {
+    return replies->pop();
+  }
+
+  // the server handles the requests queued on all lanes before it stops
+  void kill() { lanes[0]->push(typename Q::element_type{}); }
+};
+
+// server side, receives from the highest lane that is not empty
+template <typename Q, std::size_t Lanes, typename R = void>
+struct LaneServer {
+  std::array<Q*, Lanes> lanes;
+  R* replies             = nullptr;
+  std::uint32_t patience = 16;
+  std::array<std::uint32_t, Lanes> passed{};
+  // a goodbye message was received, the server stops once all lanes are empty
+  bool stopping = false;
+
+  typename Q::element_type recv() {
+    auto message = typename Q::element_type{};
+    while (!try_recv(message)) {
+      std::this_thread::yield();
+    }
+    return message;
+  }
+
+  bool try_recv(typename Q::element_type& target) {
+    while (take(target)) {
+      if (!std::span<char const>{target}.empty()) {
+        return true;
+      }
+      // the patience rule may serve the goodbye while higher lanes still hold requests
+      stopping = true;
+    }
+
+    if (stopping) {
+      target = typename Q::element_type{};
+      return true;
+    }
+    return false;
+  }
+
+  void send(auto const& message)
+    requires(is_queue<R>)
+  {
+    replies->push(message);
+  }
+
+private:
+  bool take(typename Q::element_type& target) {
+    // lowest starving lane first
+    for (std::size_t lane = 0; lane < Lanes; ++lane) {
+      if (passed[lane] >= patience && lanes[lane]->try_pop(&target)) {
+        passed[lane] = 0;
+        return true;
+      }
+    }
+
+    for (std::size_t lane = Lanes; lane-- > 0;) {
+      if (lanes[lane]->try_pop(&target)) {
+        passed[lane] = 0;
+        for (std::size_t lower = 0; lower < lane; ++lower) {
+          if (!lanes[lower]->is_empty()) {
+            ++passed[lower];
+          }
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+};
+}  // namespace erl::net
@@ -12,16 +12,17 @@
 namespace erl::message {
 struct HeapBuffer {
   std::span<char const> read(std::size_t n, std::size_t offset = 0) { return {buffer.data() + offset, n}; }
-  HeapBuffer& write(void const* data, std::size_t n) {
-    copy(static_cast<char const*>(data), static_cast<char const*>(data) + n, back_inserter(buffer));
-    return *this;
+  void write(void const* data, std::size_t n) {
+    buffer.insert(buffer.end(), static_cast<char const*>(data), static_cast<char const*>(data) + n);
   }
 
-  HeapBuffer& reserve(std::size_t n) {
-    buffer.reserve(n);
-    return *this;
+  void reserve(std::size_t n) {
+    // reserve n additional bytes
+    buffer.reserve(buffer.size() + n);
   }
 
+  [[nodiscard]] std::size_t size() const { return buffer.size(); }
+
   std::span<char const> finalize() const { return buffer; }
   [[nodiscard]] explicit operator std::span<char const>() const { return buffer; }
 
@@ -33,6 +34,27 @@ private:
   std::vector<char> buffer;
 };
 
+// staging area for messages of statically known size
+// writes go to fixed offsets, allowing the compiler to fold them into plain stores
+template <std::size_t N>
+struct FixedBuffer {
+  void write(void const* input_data, std::size_t length) {
+    assert(cursor + length <= N);
+    std::memcpy(storage + cursor, input_data, length);
+    cursor += length;
+  }
+
+  void reserve(std::size_t) {}
+
+  [[nodiscard]] char const* data() const { return storage; }
+  [[nodiscard]] std::size_t size() const { return cursor; }
+  [[nodiscard]] std::span<char const> finalize() const { return {storage, cursor}; }
+
+private:
+  char storage[N];
+  std::size_t cursor = 0;
+};
+
 template <std::size_t inline_capacity = std::hardware_destructive_interference_size - 4>
 class HybridBuffer {
 public:
@@ -89,8 +111,8 @@ public:
     auto new_size = size() + length;
     if (is_heap()) {
       if (new_size > storage.heap.capacity) {
-        // resize if necessary
-        resize_heap(new_size);
+        // resize if necessary, grow geometrically to amortize repeated writes
+        resize_heap(std::max<std::size_t>(new_size, storage.heap.capacity * 2UZ));
       }
     } else {
       if (new_size <= inline_capacity) {
@@ -114,7 +136,9 @@ public:
   void reserve(unsigned num_bytes) {
     auto new_size = size() + num_bytes;
     if (is_heap()) {
-      resize_heap(new_size);
+      if (new_size > storage.heap.capacity) {
+        resize_heap(new_size);
+      }
     } else if (new_size > inline_capacity) {
       // transition to heap
       allocate_heap(new_size);
@@ -17,6 +17,8 @@ struct MessageView {
     cursor += n;
     return ret; 
   }
+
+  [[nodiscard]] std::span<char const> remaining() const { return buffer.subspan(cursor); }
 };
 
 template <typename T>
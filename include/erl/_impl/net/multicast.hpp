@@ -0,0 +1,37 @@
+#pragma once
+#include <span>
+
+namespace erl::net {
+// publishes messages to every subscriber of a multicast ring, see queues::Disruptor
+template <typename R>
+struct RingPublisher {
+  R* ring;
+
+  void send(auto const& message) { ring->publish(message); }
+
+  // stops every subscriber, any publisher of the ring may call it any number of times
+  void kill() { ring->close(typename R::element_type{}); }
+};
+
+// receives messages of a multicast ring as views into the ring
+// a message stays valid until the next call to recv
+template <typename R>
+struct RingSubscriber {
+  typename R::Consumer* consumer;
+  bool holding = false;
+
+  std::span<char const> recv() {
+    if (holding) {
+      consumer->release();
+    }
+
+    auto message = std::span<char const>{consumer->acquire()};
+    holding      = !message.empty();
+    if (!holding) {
+      // goodbye message, let dependent subscribers see it as well
+      consumer->release();
+    }
+    return message;
+  }
+};
+}  // namespace erl::net
@@ -0,0 +1,239 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/* Worker processes
+
+Workers runs N forked copies of a server, each connected to the parent
+through its own stream socket. Messages are framed as
+
+  [size (4 bytes)] [message]
+
+Callers lease an idle worker for the duration of a call, so concurrent calls
+from different clients are spread across all workers. A worker that dies is
+restarted by the next caller that notices - the call that was in flight on
+it fails with ProcessError, the worker's state is lost.
+
+Workers are not forked by the parent. When the pool is created it forks a
+single-threaded spawner process, which forks every worker and passes the
+parent its end of the socket. Create pools before starting other threads,
+restarting a worker later on does not fork the caller.
+*/
+
+namespace erl {
+struct ProcessError : std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+namespace platform {
+struct Process {
+  std::int64_t id = -1;
+  // parent end of the socket
+  int connection = -1;
+};
+
+// forks the process that forks workers, each worker runs worker with its end of the socket
+// the calling process must not have other threads yet
+Process spawn_spawner(std::function<void(int)> const& worker);
+// closes the connection and waits for the spawner to exit, running workers are not affected
+void stop_spawner(Process& spawner);
+
+// forks a new worker through spawner
+Process spawn_worker(Process const& spawner);
+// closes the connection, the worker exits once it has read everything sent before
+// workers are reaped by the spawner, so their ids must not be signalled
+void stop_worker(Process& worker);
+
+// false if the peer is gone
+bool send_frame(int connection, std::span<char const> message);
+bool receive_frame(int connection, std::vector<char>& message);
+}  // namespace platform
+
+namespace net {
+class Workers {
+  platform::Process spawner;
+  std::vector<platform::Process> processes;
+  std::vector<bool> busy;
+  std::size_t next = 0;
+  std::mutex lock;
+  std::condition_variable available;
+
+  void stop() {
+    for (auto& process : processes) {
+      platform::stop_worker(process);
+    }
+    platform::stop_spawner(spawner);
+  }
+
+public:
+  Workers(std::size_t count, std::function<void(int)> const& body)
+      : processes(count)
+      , busy(count, false) {
+    if (count == 0) {
+      throw std::invalid_argument("Worker pools need at least one worker");
+    }
+
+    spawner = platform::spawn_spawner(body);
+    try {
+      for (auto& process : processes) {
+        process = platform::spawn_worker(spawner);
+      }
+    } catch (...) {
+      stop();
+      throw;
+    }
+  }
+
+  ~Workers() { stop(); }
+
+  Workers(Workers const&)            = delete;
+  Workers& operator=(Workers const&) = delete;
+
+  [[nodiscard]] std::size_t size() const { return processes.size(); }
+
+  // waits for an idle worker, round robin among idle ones
+  std::size_t acquire() {
+    auto guard = std::unique_lock{lock};
+    while (true) {
+      for (std::size_t offset = 0; offset < busy.size(); ++offset) {
+        auto idx = (next + offset) % busy.size();
+        if (!busy[idx]) {
+          busy[idx] = true;
+          next      = idx + 1;
+          return idx;
+        }
+      }
+      available.wait(guard);
+    }
+  }
+
+  void release(std::size_t idx) {
+    {
+      auto guard = std::lock_guard{lock};
+      busy[idx]  = false;
+    }
+    available.notify_one();
+  }
+
+  // only valid while the worker is leased
+  [[nodiscard]] int connection_of(std::size_t idx) const { return processes[idx].connection; }
+
+  // replaces a leased worker that died
+  void restart(std::size_t idx) {
+    platform::stop_worker(processes[idx]);
+    // the spawner handles one request at a time
+    auto guard     = std::lock_guard{lock};
+    processes[idx] = platform::spawn_worker(spawner);
+  }
+};
+
+// parent side, leases a worker on the first message of a call
+// rpc::BlockingCall hands the worker back once the call completed, destroying the client returns it as well
+template <typename Message>
+struct PoolClient {
+  Workers* workers;
+  std::optional<std::size_t> lease{};
+  std::vector<char> buffer{};
+
+  explicit PoolClient(Workers* workers) : workers(workers) {}
+  ~PoolClient() { release(); }
+
+  // a lease must not be shared
+  PoolClient(PoolClient const&)            = delete;
+  PoolClient& operator=(PoolClient const&) = delete;
+
+  PoolClient(PoolClient&& other) noexcept
+      : workers(other.workers)
+      , lease(std::exchange(other.lease, std::nullopt))
+      , buffer(std::move(other.buffer)) {}
+
+  PoolClient& operator=(PoolClient&& other) noexcept {
+    if (this != &other) {
+      release();
+      workers = other.workers;
+      lease   = std::exchange(other.lease, std::nullopt);
+      buffer  = std::move(other.buffer);
+    }
+    return *this;
+  }
+
+  void send(auto const& message) {
+    if (!lease) {
+      lease = workers->acquire();
+    }
+
+    auto data = std::span<char const>{message};
+    if (platform::send_frame(workers->connection_of(*lease), data)) {
+      return;
+    }
+
+    // the worker died while it was idle, nothing of this call was handled yet
+    restart();
+    if (!platform::send_frame(workers->connection_of(*lease), data)) {
+      release();
+      throw ProcessError("Could not reach worker");
+    }
+  }
+
+  Message recv() {
+    if (!lease) {
+      throw std::logic_error("No call in progress");
+    }
+
+    if (!platform::receive_frame(workers->connection_of(*lease), buffer)) {
+      restart();
+      release();
+      throw ProcessError("Worker exited during call");
+    }
+
+    auto message = Message{};
+    message.reserve(buffer.size());
+    message.write(buffer.data(), buffer.size());
+    return message;
+  }
+
+  void release() {
+    if (lease) {
+      workers->release(*std::exchange(lease, std::nullopt));
+    }
+  }
+
+private:
+  // the lease is returned if no replacement could be started
+  void restart() {
+    try {
+      workers->restart(*lease);
+    } catch (...) {
+      release();
+      throw;
+    }
+  }
+};
+
+// child side of a worker, an empty message tells the server to stop once the parent is gone
+template <typename Message>
+struct WorkerConnection {
+  int connection;
+  std::vector<char> buffer{};
+
+  void send(auto const& message) { platform::send_frame(connection, std::span<char const>{message}); }
+
+  Message recv() {
+    auto message = Message{};
+    if (platform::receive_frame(connection, buffer)) {
+      message.reserve(buffer.size());
+      message.write(buffer.data(), buffer.size());
+    }
+    return message;
+  }
+};
+}  // namespace net
+}  // namespace erl
@@ -1,6 +1,8 @@
 #pragma once
+#include <chrono>
 #include <concepts>
 #include <cstddef>
+#include <stop_token>
 
 namespace erl::net {
   template <typename T>
@@ -27,6 +29,20 @@ struct QueueClient {
     return out->pop();
   }
 
+  bool try_recv(typename V::element_type& target)
+    requires(is_queue<V>)
+  {
+    return out->try_pop(&target);
+  }
+
+  // returns an empty message on timeout or cancellation
+  template <typename Clock, typename Duration>
+  auto recv(std::stop_token const& token, std::chrono::time_point<Clock, Duration> deadline)
+    requires(is_queue<V>)
+  {
+    return out->pop(token, deadline);
+  }
+
   void kill()
     requires(is_queue<U>)
   {
@@ -1,5 +1,8 @@
 #pragma once
+#include <optional>
 #include <span>
+#include <utility>
+#include <vector>
 
 
 namespace erl::net {
@@ -11,12 +14,38 @@ struct Server {
 
   template <typename T>
   void run(T&& service) {
+    using message_type = decltype(client.recv());
+    auto pending       = std::optional<message_type>{};
+
     while (true) {
-      auto msg = client.recv();
+      auto msg = pending ? *std::exchange(pending, std::nullopt) : client.recv();
       if (msg.size() == 0) {
         break;
       }
 
+      if constexpr (requires(message_type next) {
+                      client.try_recv(next);
+                      client.template group_of<T>(std::span<char const>{msg});
+                    }) {
+        // hand consecutive requests for a method with a batch handler over at once
+        if (auto group = client.template group_of<T>(std::span<char const>{msg}); group) {
+          auto messages = std::vector<message_type>{};
+          messages.push_back(std::move(msg));
+
+          auto next = message_type{};
+          while (client.try_recv(next)) {
+            if (next.size() == 0 || client.template group_of<T>(std::span<char const>{next}) != group) {
+              pending = std::move(next);
+              break;
+            }
+            messages.push_back(std::move(next));
+          }
+
+          client.handle_group(service, std::span<message_type const>{messages});
+          continue;
+        }
+      }
+
       client.handle(service, std::span<char const>{msg});
     }
   }
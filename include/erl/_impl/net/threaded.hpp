@@ -0,0 +1,170 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <erl/_impl/rpc/concurrency.hpp>
+#include <erl/_impl/rpc/stream.hpp>
+
+namespace erl::net {
+// receives on every connection on a dedicated thread and handles calls on a pool of workers
+// which calls may overlap is controlled with rpc::concurrent, rpc::exclusive and rpc::keyed
+// calls are not ordered, clients relying on order must wait for replies
+// calls that throw are answered with an error reply, see rpc::RemoteError
+template <typename C>
+class ThreadedServer {
+  struct Connection {
+    C client;
+    // replies from different workers may target the same connection
+    std::mutex send_lock{};
+    // streamed results served on this connection, freed once the server returns
+    rpc::StreamTable streams{};
+  };
+
+  using message_type = decltype(std::declval<C&>().recv());
+
+  struct Job {
+    Connection* connection;
+    message_type message;
+  };
+
+  std::deque<Connection> connections;
+  std::size_t worker_count;
+
+  std::mutex jobs_lock;
+  std::condition_variable_any jobs_ready;
+  std::deque<Job> jobs;
+  std::exception_ptr failure;
+
+  void receive(Connection& connection) {
+    while (true) {
+      auto message = connection.client.recv();
+      if (std::span<char const>{message}.empty()) {
+        break;
+      }
+
+      {
+        auto lock = std::lock_guard{jobs_lock};
+        jobs.push_back({&connection, std::move(message)});
+      }
+      jobs_ready.notify_one();
+    }
+  }
+
+  template <typename T>
+  void work(T& service, rpc::Synchronizer& sync, std::stop_token token) {
+    using protocol = typename std::remove_cvref_t<T>::protocol;
+
+    while (true) {
+      auto job = Job{};
+      {
+        auto lock = std::unique_lock{jobs_lock};
+        // remaining jobs are drained after a stop request
+        if (!jobs_ready.wait(lock, token, [&] { return !jobs.empty(); })) {
+          return;
+        }
+        job = std::move(jobs.front());
+        jobs.pop_front();
+      }
+
+      auto data = std::span<char const>{job.message};
+      auto info = rpc::CallInfo{};
+      try {
+        auto scope = rpc::StreamScope{job.connection->streams};
+        info       = protocol::describe(service, data);
+        auto reply = sync.run(info, [&] { return protocol::dispatch(service, data); });
+
+        if constexpr (C::expects_reply) {
+          // one-way calls produce no reply
+          if (!std::span<char const>{reply}.empty()) {
+            send(*job.connection, reply);
+          }
+        }
+      } catch (...) {
+        auto error = std::current_exception();
+        {
+          auto lock = std::lock_guard{jobs_lock};
+          if (!failure) {
+            failure = error;
+          }
+        }
+
+        if constexpr (C::expects_reply) {
+          // the caller still waits for a reply
+          if (!info.oneway) {
+            try {
+              send(*job.connection, protocol::fail(data, reason_of(error)));
+            } catch (...) {
+              // the connection is gone
+            }
+          }
+        }
+      }
+    }
+  }
+
+  static void send(Connection& connection, auto const& reply) {
+    auto lock = std::lock_guard{connection.send_lock};
+    connection.client.send(reply);
+  }
+
+  static std::string reason_of(std::exception_ptr const& error) {
+    try {
+      std::rethrow_exception(error);
+    } catch (std::exception const& exception) {
+      return exception.what();
+    } catch (...) {
+      return "Unknown error";
+    }
+  }
+
+public:
+  explicit ThreadedServer(std::size_t workers = std::max(1U, std::thread::hardware_concurrency()))
+      : worker_count(std::max<std::size_t>(workers, 1)) {}
+
+  explicit ThreadedServer(C client, std::size_t workers = std::max(1U, std::thread::hardware_concurrency()))
+      : ThreadedServer(workers) {
+    add(std::move(client));
+  }
+
+  void add(C client) { connections.emplace_back(std::move(client)); }
+
+  // returns once every connection has been closed and all pending calls were handled
+  // the first exception thrown by a call is rethrown afterwards
+  template <typename T>
+  void run(T& service) {
+    auto sync = rpc::Synchronizer{};
+    auto stop = std::stop_source{};
+    {
+      auto workers = std::vector<std::jthread>{};
+      workers.reserve(worker_count);
+      for (std::size_t idx = 0; idx < worker_count; ++idx) {
+        workers.emplace_back([&] { work(service, sync, stop.get_token()); });
+      }
+
+      {
+        auto receivers = std::vector<std::jthread>{};
+        receivers.reserve(connections.size());
+        for (auto& connection : connections) {
+          receivers.emplace_back([&, target = &connection] { receive(*target); });
+        }
+      }
+
+      stop.request_stop();
+    }
+
+    if (failure) {
+      std::rethrow_exception(std::exchange(failure, nullptr));
+    }
+  }
+};
+}  // namespace erl::net
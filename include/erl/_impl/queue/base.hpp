@@ -1,4 +1,5 @@
 #pragma once
+#include <chrono>
 #include <thread>
 #include <type_traits>
 #include <stop_token>
@@ -19,6 +20,21 @@ struct QueueBase {
     return obj;
   }
 
+  // returns an empty element if the deadline passes first
+  template <typename T, typename Clock, typename Duration>
+  auto pop(this T&& self, std::stop_token const& token, std::chrono::time_point<Clock, Duration> deadline)
+      -> std::remove_cvref_t<T>::element_type {
+    typename std::remove_cvref_t<T>::element_type obj;
+
+    while(!std::forward<T>(self).try_pop(&obj)){
+      if (token.stop_requested() || Clock::now() >= deadline){
+        return {};
+      }
+      std::this_thread::yield();
+    }
+    return obj;
+  }
+
   template <typename T>
   auto pop(this T&& self) -> std::remove_cvref_t<T>::element_type {
     typename std::remove_cvref_t<T>::element_type obj;
@@ -0,0 +1,176 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <list>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/* Multicast ring buffer
+
+Every element published to a Disruptor is seen by every consumer. Consumers
+track their own position in the ring and may depend on other consumers, they
+only see an element once all of their dependencies are done with it:
+
+  publisher -> metrics -+
+            -> audit ---+-> archive
+
+Elements are never copied per consumer, consumers get references into the
+ring. The publisher waits for the slowest consumer once the ring is full.
+
+Consumers must be subscribed before the first element is published.
+
+close() publishes a final element once. Elements published after it are
+dropped instead of waiting for consumers that already stopped.
+*/
+
+namespace erl::queues {
+enum class Producers : std::uint8_t { single, multiple };
+
+template <typename T, std::size_t N, Producers P = Producers::single>
+class Disruptor {
+  static_assert(N >= 2, "Must be able to store at least 2 elements.");
+  static_assert((N & (N - 1)) == 0, "Maximum number of elements must be power of 2.");
+  constexpr static auto buffer_mask    = N - 1;
+  constexpr static auto cacheline_size = std::hardware_destructive_interference_size;
+
+public:
+  using element_type             = T;
+  static constexpr auto capacity = N;
+
+  class Consumer {
+    friend Disruptor;
+
+    Disruptor* ring;
+    // consumers this one waits for, the publisher if empty
+    std::vector<Consumer const*> dependencies;
+    alignas(cacheline_size) std::atomic<std::int64_t> position{-1};
+
+    bool is_available(std::int64_t sequence) const {
+      if (dependencies.empty()) {
+        return ring->published[sequence & buffer_mask].load(std::memory_order_acquire) == sequence;
+      }
+      return std::ranges::all_of(dependencies, [&](Consumer const* dependency) {
+        return dependency->position.load(std::memory_order_acquire) >= sequence;
+      });
+    }
+
+  public:
+    Consumer(Disruptor* ring, std::vector<Consumer const*> dependencies)
+        : ring(ring)
+        , dependencies(std::move(dependencies)) {}
+
+    // waits for the next element, it stays valid until it is released
+    T const& acquire() const {
+      auto sequence = position.load(std::memory_order_relaxed) + 1;
+      while (!is_available(sequence)) {
+        std::this_thread::yield();
+      }
+      return ring->buffer[sequence & buffer_mask];
+    }
+
+    void release() { position.fetch_add(1, std::memory_order_release); }
+
+    // calls fnc for all elements that are currently available, returns their number
+    template <typename F>
+    std::size_t poll(F&& fnc) {
+      auto first    = position.load(std::memory_order_relaxed) + 1;
+      auto sequence = first;
+      while (is_available(sequence)) {
+        fnc(ring->buffer[sequence & buffer_mask]);
+        ++sequence;
+      }
+      position.store(sequence - 1, std::memory_order_release);
+      return static_cast<std::size_t>(sequence - first);
+    }
+  };
+
+  Disruptor() {
+    for (std::size_t idx = 0; idx < N; ++idx) {
+      published[idx].store(std::int64_t(idx) - std::int64_t(N), std::memory_order_relaxed);
+    }
+  }
+  Disruptor(Disruptor const&)      = delete;
+  void operator=(Disruptor const&) = delete;
+
+  // new consumer that sees elements after all consumers in `after` are done with them
+  Consumer& subscribe(std::initializer_list<Consumer const*> after = {}) {
+    return consumers.emplace_back(this, std::vector<Consumer const*>(after));
+  }
+
+  // returns false if the element was dropped because the ring is closed
+  template <typename U>
+  bool publish(U&& value) {
+    auto sequence = claim();
+
+    // the slot was last used by sequence - N
+    while (sequence - std::int64_t(N) > slowest()) {
+      if (sequence > last.load(std::memory_order_acquire)) {
+        // consumers stop at the final element and will never make room
+        return false;
+      }
+      std::this_thread::yield();
+    }
+
+    if (sequence > last.load(std::memory_order_acquire)) {
+      return false;
+    }
+    store(sequence, std::forward<U>(value));
+    return true;
+  }
+
+  // publishes value as the final element, only the first call has an effect
+  // with a single producer it must be called by the producing thread
+  template <typename U>
+  void close(U&& value) {
+    if (closing.exchange(true, std::memory_order_acq_rel)) {
+      return;
+    }
+
+    auto sequence = claim();
+    while (sequence - std::int64_t(N) > slowest()) {
+      std::this_thread::yield();
+    }
+    store(sequence, std::forward<U>(value));
+    last.store(sequence, std::memory_order_release);
+  }
+
+private:
+  std::int64_t claim() {
+    if constexpr (P == Producers::single) {
+      return next++;
+    } else {
+      return claimed.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  template <typename U>
+  void store(std::int64_t sequence, U&& value) {
+    buffer[sequence & buffer_mask] = std::forward<U>(value);
+    published[sequence & buffer_mask].store(sequence, std::memory_order_release);
+  }
+
+  std::int64_t slowest() const {
+    auto minimum = std::numeric_limits<std::int64_t>::max();
+    for (auto const& consumer : consumers) {
+      minimum = std::min(minimum, consumer.position.load(std::memory_order_acquire));
+    }
+    return minimum;
+  }
+
+  T buffer[N];
+  std::atomic<std::int64_t> published[N];
+  std::list<Consumer> consumers;
+
+  alignas(cacheline_size) std::int64_t next = 0;
+  alignas(cacheline_size) std::atomic<std::int64_t> claimed{0};
+  // sequence of the final element
+  std::atomic<std::int64_t> last{std::numeric_limits<std::int64_t>::max()};
+  std::atomic<bool> closing{false};
+};
+}  // namespace erl::queues
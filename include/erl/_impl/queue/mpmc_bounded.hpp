@@ -2,6 +2,7 @@
 #include <atomic>
 #include <cstddef>
 #include <new>
+#include <utility>
 
 #include "base.hpp"
 
@@ -46,7 +47,7 @@ struct BoundedMPMC : impl::QueueBase {
       }
     }
 
-    new (&cell->data) T(std::forward<U>(data));
+    cell->data = std::forward<U>(data);
     cell->sequence.store(pos + 1, std::memory_order_release);
 
     return true;
@@ -71,7 +72,7 @@ struct BoundedMPMC : impl::QueueBase {
       }
     }
 
-    new (target) T(std::move(cell->data));
+    *target = std::move(cell->data);
     cell->sequence.store(pos + buffer_mask + 1, std::memory_order_release);
     return true;
   }
@@ -2,6 +2,7 @@
 #include <atomic>
 #include <cstddef>
 #include <new>
+#include <utility>
 
 #include "base.hpp"
 
@@ -17,7 +18,8 @@ struct BoundedSPSC : impl::QueueBase {
   using element_type                   = T;
   using cell_type                      = T;
 
-  bool try_push(T const& data) {
+  template <typename U>
+  bool try_push(U&& data) {
     auto pos  = write_pos.load(std::memory_order_relaxed);
     auto next = (pos + 1) & buffer_mask;
     if (next == read_pos_cached) {
@@ -27,7 +29,7 @@ struct BoundedSPSC : impl::QueueBase {
       }
     }
 
-    new (buffer + pos) T(data);
+    buffer[pos] = std::forward<U>(data);
     write_pos.store(next, std::memory_order_release);
     return true;
   }
@@ -41,7 +43,7 @@ struct BoundedSPSC : impl::QueueBase {
       }
     }
 
-    new (target) T(buffer[pos]);
+    *target = std::move(buffer[pos]);
     auto next = (pos + 1) & buffer_mask;
     read_pos.store(next, std::memory_order_release);
     return true;
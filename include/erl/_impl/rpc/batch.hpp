@@ -0,0 +1,107 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+#include <experimental/meta>
+
+#include <erl/_impl/rpc/proxy.hpp>
+
+namespace erl::rpc {
+// result of a batched call, available once the batch has been flushed
+// only valid until the next flush of the same batch
+template <typename Batch, typename R>
+class Deferred {
+  Batch const* batch;
+  std::size_t position;
+  std::size_t generation;
+  std::uint32_t opcode;
+
+public:
+  Deferred(Batch const* batch, std::size_t position, std::size_t generation, std::uint32_t opcode)
+      : batch(batch)
+      , position(position)
+      , generation(generation)
+      , opcode(opcode) {}
+
+  R get() const { return batch->template result<R>(position, generation, opcode); }
+};
+
+// collects calls to a remote service and sends them as a single message
+//
+//   auto batch = remote.batch();
+//   batch.set(1, 2);
+//   auto value = batch.get(1);
+//   batch.flush();
+//   value.get();
+//
+// calls that have not been flushed when the batch is destroyed are discarded
+template <typename Service, typename Client>
+class Batch : public Proxy<Service, Batch<Service, Client>> {
+  using protocol     = typename Service::protocol;
+  using message_type = typename protocol::message_type;
+
+  Client* client;
+  std::vector<message_type> requests{};
+  message_type reply{};
+  std::vector<std::span<char const>> replies{};
+  std::size_t generation = 0;
+
+public:
+  explicit Batch(Client* client) : Proxy<Service, Batch>{this}, client(client) {}
+
+  // the proxy base refers to this object
+  Batch(Batch const&)            = delete;
+  Batch& operator=(Batch const&) = delete;
+
+  // one-way calls have no result
+  template <typename S, typename R, std::meta::info Meta = std::meta::info{}, typename... Args>
+  auto call(std::uint32_t opcode, Args&&... args) {
+    static_assert(!is_streaming<Meta>, "Streamed results cannot be batched");
+    if constexpr (requires { client->template make_request<S, Meta>(opcode, std::forward<Args>(args)...); }) {
+      // honors the result of a schema handshake
+      requests.push_back(client->template make_request<S, Meta>(opcode, std::forward<Args>(args)...));
+    } else {
+      requests.push_back(protocol::template seal<S, Meta>(protocol::request(opcode, std::forward<Args>(args)...)));
+    }
+    if constexpr (!is_oneway<Meta>) {
+      return Deferred<Batch, R>{this, requests.size() - 1, generation, opcode};
+    }
+  }
+
+  [[nodiscard]] std::size_t size() const { return requests.size(); }
+
+  // sends all pending calls in one message and waits for the combined reply if the client expects one
+  void flush() {
+    if (requests.empty()) {
+      return;
+    }
+
+    auto message = protocol::make_batch(requests);
+    requests.clear();
+    ++generation;
+
+    if constexpr (Client::expects_reply) {
+      if constexpr (requires { client->template receive<protocol>(); }) {
+        client->send(client->template tag<protocol>(std::move(message)));
+        reply = client->template receive<protocol>();
+      } else {
+        client->send(message);
+        reply = client->recv();
+      }
+      replies = protocol::read_batch_reply(std::span<char const>{reply});
+    } else {
+      client->send(message);
+    }
+  }
+
+  template <typename R>
+  R result(std::size_t position, std::size_t issued, std::uint32_t opcode) const {
+    // results refer to the last flush, calls are issued before it
+    assert(issued + 1 == generation && "Batch has not been flushed or was flushed again");
+    assert(position < replies.size());
+    return protocol::template read_response<R>(opcode, replies[position]);
+  }
+};
+}  // namespace erl::rpc
@@ -0,0 +1,177 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <experimental/meta>
+
+#include <erl/_impl/util/meta.hpp>
+
+/* Client-side result caching
+
+Replies to methods annotated with rpc::cacheable are kept by the client and
+reused for later calls with identical encoded arguments, without contacting
+the server again. Entries expire after their time to live (0 keeps them until
+they are invalidated) and the least recently used entry is evicted once a
+method exceeds its capacity.
+
+Servers invalidate cached results with rpc::invalidate<Service>(). Replies of
+services with cacheable methods carry the current cache epoch of the service,
+clients drop all cached results of a connection once they see a new epoch.
+
+Invalidation is pull-only by design. Servers never send messages a client did
+not ask for, so an invalidation reaches a client only with its next reply that
+was not served from the cache. Until then the client may return stale results,
+bounded only by their time to live. Plain rpc::cacheable therefore expires
+entries after a second. Use a ttl of 0 only for results that never change or
+for clients that regularly call other methods.
+
+The epoch is a single counter per Service in the server process. Any
+invalidation drops the cached results of every connection, including entries
+unrelated to the change.
+*/
+
+namespace erl::rpc {
+namespace annotations {
+// results only depend on the arguments and may be reused by the client
+struct Cacheable {
+  std::int64_t ttl_ms;
+  std::uint32_t capacity;
+
+  consteval Cacheable operator()(std::chrono::milliseconds ttl, std::uint32_t capacity = 1024) const {
+    return {ttl.count(), capacity};
+  }
+};
+// invalidations are not pushed to clients, entries expire after one second by default
+constexpr inline Cacheable cacheable{1000, 1024};
+}  // namespace annotations
+
+template <std::meta::info Meta>
+constexpr inline bool is_cacheable =
+    Meta != std::meta::info{} && meta::has_annotation<annotations::Cacheable>(Meta);
+
+template <typename Service>
+consteval bool has_cacheable_methods() {
+  for (auto member : typename Service::policy{}.template remote_members<Service>()) {
+    if (meta::has_annotation<annotations::Cacheable>(member)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+namespace _cache_impl {
+template <typename Service>
+inline std::atomic<std::uint64_t> epoch{0};
+}
+
+// drops cached results of all methods of Service on every client
+template <typename Service>
+void invalidate() {
+  // publishes the changes that made cached results stale, see RPCProtocol::epoch_before_call
+  _cache_impl::epoch<Service>.fetch_add(1, std::memory_order_release);
+}
+
+template <typename Service>
+std::uint64_t cache_epoch() {
+  return _cache_impl::epoch<Service>.load(std::memory_order_acquire);
+}
+
+// encoded replies of cacheable methods keyed on their encoded requests
+class ResultCache {
+  using clock = std::chrono::steady_clock;
+
+  struct Entry {
+    std::string request;
+    std::vector<char> reply;
+    clock::time_point expiry;
+  };
+
+  // entries of a single method, most recently used first
+  struct Method {
+    std::list<Entry> entries;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+  };
+
+  std::unordered_map<std::uint32_t, Method> methods;
+  std::uint64_t epoch = 0;
+
+public:
+  ResultCache() = default;
+
+  // index refers to keys owned by entries, copies start out empty
+  ResultCache(ResultCache const& other) : epoch(other.epoch) {}
+  ResultCache& operator=(ResultCache const& other) {
+    if (this != &other) {
+      clear();
+      epoch = other.epoch;
+    }
+    return *this;
+  }
+
+  ResultCache(ResultCache&&)            = default;
+  ResultCache& operator=(ResultCache&&) = default;
+
+  std::optional<std::span<char const>> find(std::uint32_t opcode, std::span<char const> request) {
+    auto method = methods.find(opcode);
+    if (method == methods.end()) {
+      return std::nullopt;
+    }
+
+    auto& [entries, index] = method->second;
+    auto it                = index.find(std::string_view{request.data(), request.size()});
+    if (it == index.end()) {
+      return std::nullopt;
+    }
+
+    if (clock::now() >= it->second->expiry) {
+      entries.erase(it->second);
+      index.erase(it);
+      return std::nullopt;
+    }
+
+    entries.splice(entries.begin(), entries, it->second);
+    return std::span<char const>{it->second->reply};
+  }
+
+  void store(std::uint32_t opcode, std::span<char const> request, std::span<char const> reply,
+             annotations::Cacheable policy) {
+    if (policy.capacity == 0) {
+      return;
+    }
+
+    auto& [entries, index] = methods[opcode];
+    if (auto it = index.find(std::string_view{request.data(), request.size()}); it != index.end()) {
+      entries.erase(it->second);
+      index.erase(it);
+    }
+
+    auto expiry = policy.ttl_ms == 0 ? clock::time_point::max()
+                                     : clock::now() + std::chrono::milliseconds{policy.ttl_ms};
+    entries.push_front(Entry{{request.begin(), request.end()}, {reply.begin(), reply.end()}, expiry});
+    index.emplace(entries.front().request, entries.begin());
+
+    while (entries.size() > policy.capacity) {
+      index.erase(entries.back().request);
+      entries.pop_back();
+    }
+  }
+
+  // drops everything if the server's cache epoch changed
+  void observe(std::uint64_t current) {
+    if (current != epoch) {
+      clear();
+      epoch = current;
+    }
+  }
+
+  void clear() { methods.clear(); }
+};
+}  // namespace erl::rpc
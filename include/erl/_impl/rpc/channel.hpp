@@ -0,0 +1,191 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+#include <experimental/meta>
+
+#include <erl/_impl/util/meta.hpp>
+#include <erl/_impl/rpc/proxy.hpp>
+
+/* Typed in-process channels
+
+Calls between threads of the same process do not need a wire format. Instead of
+serializing into a message, the proxy enqueues the arguments of a call as a
+tuple. Every remote member function of the service gets its own alternative of
+
+  rpc::Request<Service> = std::variant<std::monostate, std::tuple<Args...>...>
+
+in the order returned by the service policy. Replies use the same layout with
+the return type of every method. The server moves the arguments out of the
+tuple straight into the member function, nothing is ever copied into a buffer.
+
+An empty request (std::monostate) stops the server.
+
+Only plain member functions are supported. Function templates and custom
+handlers work on encoded messages and still need a serializing transport.
+*/
+
+namespace erl::rpc {
+namespace _channel_impl {
+consteval bool is_typed(std::meta::info member) {
+  return is_function(member) && !meta::has_annotation<annotations::Handler>(member);
+}
+
+template <typename Service>
+consteval std::vector<std::meta::info> methods_of() {
+  std::vector<std::meta::info> methods{};
+  for (auto member : typename Service::policy{}.template remote_members<Service>()) {
+    if (is_typed(member)) {
+      methods.push_back(member);
+    }
+  }
+  return methods;
+}
+
+consteval std::meta::info arguments_of(std::meta::info fnc) {
+  std::vector<std::meta::info> types{};
+  for (auto param : parameters_of(fnc)) {
+    types.push_back(remove_cvref(type_of(param)));
+  }
+  return substitute(^^std::tuple, types);
+}
+
+consteval std::meta::info result_of(std::meta::info fnc) {
+  auto type = return_type_of(fnc);
+  return type == ^^void ? ^^std::monostate : remove_cvref(type);
+}
+
+template <typename Service>
+consteval std::meta::info make_request() {
+  std::vector<std::meta::info> alternatives{^^std::monostate};
+  for (auto method : methods_of<Service>()) {
+    alternatives.push_back(arguments_of(method));
+  }
+  return substitute(^^std::variant, alternatives);
+}
+
+template <typename Service>
+consteval std::meta::info make_reply() {
+  std::vector<std::meta::info> alternatives{^^std::monostate};
+  for (auto method : methods_of<Service>()) {
+    alternatives.push_back(result_of(method));
+  }
+  return substitute(^^std::variant, alternatives);
+}
+
+// alternative of the request and reply variants used by `fnc`
+template <typename Service>
+consteval std::size_t alternative_of(std::meta::info fnc) {
+  auto methods = methods_of<Service>();
+  for (std::size_t idx = 0; idx < methods.size(); ++idx) {
+    if (methods[idx] == fnc) {
+      return idx + 1;
+    }
+  }
+  return 0;
+}
+}  // namespace _channel_impl
+
+template <typename Service>
+using Request = [:_channel_impl::make_request<Service>():];
+
+template <typename Service>
+using Reply = [:_channel_impl::make_reply<Service>():];
+
+// client side of a typed channel, pass it to rpc::Proxy
+// V is void for fire-and-forget channels
+template <typename U, typename V>
+struct ChannelClient {
+  U* requests;
+  V* replies;
+
+  static constexpr bool expects_reply = !std::is_void_v<V>;
+
+  template <typename Service, typename R, std::meta::info Meta = std::meta::info{}, typename... Args>
+  R call(std::uint32_t, Args&&... args) {
+    static_assert(Meta != std::meta::info{} && _channel_impl::is_typed(Meta),
+                  "Typed channels only support plain member functions");
+    static_assert(!is_streaming<Meta>, "Streaming methods need a serializing transport");
+    static_assert(expects_reply || std::is_void_v<R>, "Fire-and-forget channels cannot return values");
+    constexpr auto alternative = _channel_impl::alternative_of<Service>(Meta);
+
+    requests->push(Request<Service>{std::in_place_index<alternative>, std::forward<Args>(args)...});
+
+    if constexpr (expects_reply && !is_oneway<Meta>) {
+      auto reply = replies->pop();
+      if constexpr (!std::is_void_v<R>) {
+        return std::get<alternative>(std::move(reply));
+      }
+    }
+  }
+
+  void kill() { requests->push(typename U::element_type{}); }
+};
+
+template <typename U>
+ChannelClient(U*, std::nullptr_t) -> ChannelClient<U, void>;
+
+// server side of a typed channel
+template <typename U, typename V>
+struct ChannelServer {
+  U* requests;
+  V* replies;
+
+  template <typename Service>
+  static void invoke(Service& service, Request<Service>& request, Reply<Service>& reply) {
+    using entry = void (*)(Service&, Request<Service>&, Reply<Service>&);
+    constexpr static auto table = [:meta::expand(_channel_impl::methods_of<Service>()):] >> []<auto... Methods> {
+      return std::array<entry, sizeof...(Methods) + 1>{
+          [](Service&, Request<Service>&, Reply<Service>&) {},
+          &ChannelServer::template invoke_method<Service, Methods>...};
+    };
+    table[request.index()](service, request, reply);
+  }
+
+  template <typename Service>
+  void run(Service& service) {
+    while (true) {
+      auto request = requests->pop();
+      if (request.index() == 0) {
+        break;
+      }
+
+      auto reply = Reply<Service>{};
+      invoke(service, request, reply);
+      if constexpr (!std::is_void_v<V>) {
+        if (reply.index() != 0) {
+          replies->push(std::move(reply));
+        }
+      }
+    }
+  }
+
+private:
+  template <typename Service, std::meta::info Meta>
+  static void invoke_method(Service& service, Request<Service>& request, Reply<Service>& reply) {
+    constexpr auto alternative = _channel_impl::alternative_of<Service>(Meta);
+    auto handler               = [&](auto&&... args) -> decltype(auto) {
+      return service.[:Meta:](std::forward<decltype(args)>(args)...);
+    };
+    auto&& args = std::get<alternative>(std::move(request));
+
+    if constexpr (return_type_of(Meta) == ^^void) {
+      std::apply(handler, std::move(args));
+      if constexpr (!is_oneway<Meta>) {
+        reply.template emplace<alternative>();
+      }
+    } else {
+      reply.template emplace<alternative>(std::apply(handler, std::move(args)));
+    }
+  }
+};
+
+template <typename U>
+ChannelServer(U*, std::nullptr_t) -> ChannelServer<U, void>;
+}  // namespace erl::rpc
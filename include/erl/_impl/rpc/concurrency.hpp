@@ -0,0 +1,102 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <experimental/meta>
+
+#include <erl/_impl/util/meta.hpp>
+
+namespace erl::rpc {
+namespace annotations {
+// may run in parallel with any other call that is not exclusive
+struct ConcurrentTag {
+} constexpr inline concurrent{};
+
+// runs alone, default for methods without concurrency annotation
+struct ExclusiveTag {
+} constexpr inline exclusive{};
+
+// calls with equal values of the named parameter run one at a time, others run in parallel
+struct Keyed {
+  char const* parameter;
+};
+
+consteval Keyed keyed(std::string_view parameter) {
+  return {std::define_static_string(parameter)};
+}
+}  // namespace annotations
+
+enum class Concurrency : std::uint8_t { exclusive, concurrent, keyed };
+
+// concurrency of a method, method annotations take precedence over service annotations
+template <typename Service, std::meta::info Meta>
+consteval Concurrency concurrency_of() {
+  if (meta::has_annotation<annotations::Keyed>(Meta)) {
+    return Concurrency::keyed;
+  }
+  if (meta::has_annotation<annotations::ConcurrentTag>(Meta)) {
+    return Concurrency::concurrent;
+  }
+  if (meta::has_annotation<annotations::ExclusiveTag>(Meta)) {
+    return Concurrency::exclusive;
+  }
+
+  if (meta::has_annotation<annotations::ConcurrentTag>(^^Service)) {
+    return Concurrency::concurrent;
+  }
+  return Concurrency::exclusive;
+}
+
+// position of the parameter named by rpc::keyed
+template <std::meta::info Meta>
+consteval std::size_t key_parameter() {
+  auto name   = std::string_view{annotation_of_type<annotations::Keyed>(Meta)->parameter};
+  auto params = parameters_of(Meta);
+  for (std::size_t idx = 0; idx < params.size(); ++idx) {
+    if (has_identifier(params[idx]) && identifier_of(params[idx]) == name) {
+      return idx;
+    }
+  }
+  return params.size();
+}
+
+struct CallInfo {
+  Concurrency concurrency = Concurrency::exclusive;
+  std::size_t key         = 0;
+  // the caller does not wait for a reply
+  bool oneway = false;
+};
+
+// serializes calls according to their concurrency
+// keyed calls hash onto a fixed number of stripes, so distinct keys may still contend
+class Synchronizer {
+  constexpr static std::size_t stripes = 64;
+
+  std::shared_mutex service_lock;
+  std::array<std::mutex, stripes> key_locks;
+
+public:
+  template <typename F>
+  decltype(auto) run(CallInfo const& info, F&& fnc) {
+    switch (info.concurrency) {
+      case Concurrency::concurrent: {
+        auto lock = std::shared_lock{service_lock};
+        return std::forward<F>(fnc)();
+      }
+      case Concurrency::keyed: {
+        auto lock     = std::shared_lock{service_lock};
+        auto key_lock = std::lock_guard{key_locks[info.key % stripes]};
+        return std::forward<F>(fnc)();
+      }
+      case Concurrency::exclusive:
+      default: {
+        auto lock = std::unique_lock{service_lock};
+        return std::forward<F>(fnc)();
+      }
+    }
+  }
+};
+}  // namespace erl::rpc
@@ -0,0 +1,89 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <stop_token>
+
+/* Deadlines and cancellation
+
+Blocking calls made while a CallScope is alive carry its deadline in the request
+header. Servers reply to requests whose deadline has already passed without
+dispatching them, callers stop waiting once the deadline passes or the stop
+token is triggered.
+
+  {
+    auto scope = rpc::CallScope{50ms, stop.get_token()};
+    remote.lookup(key);  // throws rpc::DeadlineExceeded or rpc::Cancelled
+  }
+
+Deadlines are absolute system_clock time points, so both sides need
+reasonably synchronized clocks. Waiting can only be interrupted if the
+client supports a timed recv, otherwise the caller blocks until the server
+rejects the expired request. Requests the caller may stop waiting for carry a
+call id which the server echoes, so late replies to calls that already gave up
+are dropped instead of being taken for the reply to the next call.
+*/
+
+namespace erl::rpc {
+struct DeadlineExceeded : std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+struct Cancelled : std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+struct CallOptions {
+  using clock = std::chrono::system_clock;
+
+  clock::time_point deadline = clock::time_point::max();
+  std::stop_token stop_token{};
+
+  [[nodiscard]] bool has_deadline() const { return deadline != clock::time_point::max(); }
+  [[nodiscard]] bool is_bounded() const { return has_deadline() || stop_token.stop_possible(); }
+};
+
+namespace _deadline_impl {
+inline thread_local CallOptions current{};
+}
+
+// options applied to blocking calls of the current thread
+inline CallOptions const& call_options() {
+  return _deadline_impl::current;
+}
+
+// applies options to all blocking calls of this thread while in scope
+// nested scopes can only shorten the deadline
+class CallScope {
+  CallOptions previous;
+
+public:
+  explicit CallScope(CallOptions options) : previous(_deadline_impl::current) {
+    options.deadline = std::min(options.deadline, previous.deadline);
+    if (!options.stop_token.stop_possible()) {
+      options.stop_token = previous.stop_token;
+    }
+    _deadline_impl::current = std::move(options);
+  }
+
+  explicit CallScope(std::chrono::nanoseconds timeout, std::stop_token token = {})
+      : CallScope(CallOptions{.deadline   = CallOptions::clock::now() +
+                                            std::chrono::duration_cast<CallOptions::clock::duration>(timeout),
+                              .stop_token = std::move(token)}) {}
+
+  ~CallScope() { _deadline_impl::current = std::move(previous); }
+
+  CallScope(CallScope const&)            = delete;
+  CallScope& operator=(CallScope const&) = delete;
+};
+
+// wire representation of a deadline, nanoseconds since the epoch
+inline std::int64_t encode_deadline(CallOptions::clock::time_point deadline) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+}
+
+inline bool is_expired(std::int64_t deadline) {
+  return encode_deadline(CallOptions::clock::now()) > deadline;
+}
+}  // namespace erl::rpc
@@ -1,35 +1,181 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <span>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "concurrency.hpp"
+#include "metrics.hpp"
 
 namespace erl::rpc::_dispatch_impl {
-#define $generate_case(Idx)                                   \
-  case (Idx):                                                 \
-    if constexpr ((Idx) < sizeof...(Members)) {           \
-      using call_type = Members...[Idx];                      \
-      return call_type::dispatch(std::forward<T>(obj), args); \
-    }                                                         \
-    std::unreachable();
-
-#define $generate_strategy(Idx, Stamper)                                                     \
-  template <>                                                                                \
-  struct DispatchStrategy<(Idx)> {                                                           \
-    template <typename T, typename... Members>                                               \
-    static constexpr auto dispatch(T&& obj, std::size_t index, std::span<char const> args) { \
-      switch (index) {                                                                       \
-        Stamper(0, $generate_case);                                                          \
-        default: throw std::out_of_range("Invalid opcode");                                  \
-      }                                                                                      \
-    }                                                                                        \
-  }
-
-template <int>
-struct DispatchStrategy;
-$generate_strategy(1, $stamp(4));    // 4^1 potential states
-$generate_strategy(2, $stamp(16));   // 4^2 potential states
-$generate_strategy(3, $stamp(64));   // 4^3 potential states
-$generate_strategy(4, $stamp(256));  // 4^4 potential states
-
-#undef $generate_strategy
-#undef $generate_case
+// regular field-wise encoded call
+struct Call {
+  template <typename M, typename T>
+  static constexpr decltype(auto) visit(T&& obj, std::span<char const> args) {
+    return M::dispatch(std::forward<T>(obj), args);
+  }
+};
+
+// arguments were sent as raw bytes after a successful schema handshake
+struct RawCall {
+  template <typename M, typename T>
+  static constexpr auto visit(T&& obj, std::span<char const> args)
+      -> decltype(M::dispatch(std::forward<T>(obj), args)) {
+    if constexpr (requires { M::dispatch_raw(std::forward<T>(obj), args); }) {
+      return M::dispatch_raw(std::forward<T>(obj), args);
+    } else {
+      throw std::invalid_argument("Method does not support raw encoding");
+    }
+  }
+};
+
+// continuation of a streamed result
+struct StreamCall {
+  template <typename M, typename T>
+  static constexpr auto visit(T&& obj, std::span<char const> args)
+      -> decltype(M::dispatch(std::forward<T>(obj), args)) {
+    if constexpr (requires { M::dispatch_stream(std::forward<T>(obj), args); }) {
+      return M::dispatch_stream(std::forward<T>(obj), args);
+    } else {
+      throw std::invalid_argument("Method does not stream its result");
+    }
+  }
+};
+
+// records server side metrics of the wrapped visitor, see rpc::stats
+template <typename Visitor>
+struct Metered {
+  template <typename M, typename T>
+  static constexpr auto visit(T&& obj, std::span<char const> args)
+      -> decltype(Visitor::template visit<M>(std::forward<T>(obj), args)) {
+    auto probe = Probe::start_call<std::remove_cvref_t<T>>(Side::server, M::opcode);
+    probe.received(args.size());
+    auto reply = Visitor::template visit<M>(std::forward<T>(obj), args);
+    probe.sent(std::span<char const>{reply}.size());
+    return reply;
+  }
+};
+
+// concurrency requirements of a call without executing it
+template <bool Raw>
+struct Describe {
+  template <typename M, typename T>
+  static constexpr CallInfo visit(T&&, std::span<char const> args) {
+    if constexpr (requires { M::describe(args, Raw); }) {
+      return M::describe(args, Raw);
+    } else {
+      return {};
+    }
+  }
+};
+
+constexpr std::uint32_t mix(std::uint32_t value, std::uint32_t seed) {
+  // murmur3 finalizer
+  value ^= seed;
+  value ^= value >> 16;
+  value *= 0x85eb'ca6bU;
+  value ^= value >> 13;
+  value *= 0xc2b2'ae35U;
+  value ^= value >> 16;
+  return value;
+}
+
+// compile-time perfect hash over a fixed set of opcodes ("hash and displace")
+// opcodes are first distributed into buckets, then every bucket searches a seed
+// that maps all of its opcodes to free slots - larger buckets are placed first
+template <std::size_t N>
+struct PerfectHash {
+  constexpr static std::uint32_t empty      = ~0U;
+  constexpr static std::size_t bucket_count = N / 2 + 1;
+  constexpr static std::size_t table_size   = std::bit_ceil(2 * N + 1);
+
+  std::array<std::uint32_t, bucket_count> seeds{};
+  std::array<std::uint32_t, table_size> keys{};
+
+  // opcodes must be unique, otherwise the seed search cannot terminate
+  consteval explicit PerfectHash(std::array<std::uint32_t, N> const& opcodes) {
+    keys.fill(empty);
+
+    std::vector<std::vector<std::uint32_t>> buckets(bucket_count);
+    for (auto opcode : opcodes) {
+      buckets[bucket_of(opcode)].push_back(opcode);
+    }
 
+    std::vector<std::size_t> order(bucket_count);
+    for (std::size_t idx = 0; idx < bucket_count; ++idx) {
+      order[idx] = idx;
+    }
+    std::ranges::sort(order, [&](std::size_t lhs, std::size_t rhs) {
+      return buckets[lhs].size() != buckets[rhs].size() ? buckets[lhs].size() > buckets[rhs].size() : lhs < rhs;
+    });
+
+    for (auto bucket : order) {
+      if (buckets[bucket].empty()) {
+        break;
+      }
+
+      for (std::uint32_t seed = 1;; ++seed) {
+        std::vector<std::size_t> slots;
+        for (auto opcode : buckets[bucket]) {
+          auto slot = mix(opcode, seed) & (table_size - 1);
+          if (keys[slot] != empty || std::ranges::contains(slots, slot)) {
+            break;
+          }
+          slots.push_back(slot);
+        }
+
+        if (slots.size() == buckets[bucket].size()) {
+          seeds[bucket] = seed;
+          for (std::size_t idx = 0; idx < slots.size(); ++idx) {
+            keys[slots[idx]] = buckets[bucket][idx];
+          }
+          break;
+        }
+      }
+    }
+  }
+
+  constexpr static std::size_t bucket_of(std::uint32_t opcode) { return mix(opcode, 0) % bucket_count; }
+
+  [[nodiscard]] constexpr std::size_t slot_of(std::uint32_t opcode) const {
+    return mix(opcode, seeds[bucket_of(opcode)]) & (table_size - 1);
+  }
+
+  [[nodiscard]] constexpr bool contains(std::uint32_t opcode) const { return keys[slot_of(opcode)] == opcode; }
+};
+
+constexpr bool all_unique(auto opcodes) {
+  std::ranges::sort(opcodes);
+  return std::ranges::adjacent_find(opcodes) == opcodes.end();
+}
+
+// flat table of function pointers indexed by perfect hash slot
+template <auto const& Lookup, typename Visitor, typename T, typename... Members>
+struct DispatchTable {
+  using result_type = decltype(Visitor::template visit<Members...[0]>(std::declval<T>(), std::span<char const>{}));
+  using entry_type  = result_type (*)(T&&, std::span<char const>);
+
+  template <typename M>
+  static result_type invoke(T&& obj, std::span<char const> args) {
+    return Visitor::template visit<M>(std::forward<T>(obj), args);
+  }
+
+  constexpr static auto entries = [] {
+    std::array<entry_type, Lookup.table_size> table{};
+    ((table[Lookup.slot_of(Members::opcode)] = &invoke<Members>), ...);
+    return table;
+  }();
+
+  static result_type dispatch(T&& obj, std::uint32_t opcode, std::span<char const> args) {
+    if (!Lookup.contains(opcode)) {
+      throw std::out_of_range("Invalid opcode");
+    }
+    return entries[Lookup.slot_of(opcode)](std::forward<T>(obj), args);
+  }
+};
 }  // namespace erl::rpc::_dispatch_impl
@@ -0,0 +1,202 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <span>
+#include <string_view>
+#include <vector>
+#include <experimental/meta>
+
+#include <erl/_impl/util/meta.hpp>
+#include "schema.hpp"
+
+/* Per-method RPC metrics
+
+Define ERL_RPC_METRICS=1 (CMake option ERL_RPC_METRICS) to count calls, errors
+and bytes of every remote method and to record their latency. Both sides keep
+their own metrics, the client measures full round trips while the server only
+measures the dispatch of a call.
+
+Without ERL_RPC_METRICS the probes are empty and rpc::stats returns nothing.
+*/
+
+#ifndef ERL_RPC_METRICS
+#define ERL_RPC_METRICS 0
+#endif
+
+namespace erl::rpc {
+enum class Side : std::uint8_t { client, server };
+
+// latency histogram with power of two buckets, bucket i counts durations below 2^i nanoseconds
+struct Histogram {
+  constexpr static std::size_t bucket_count = 40;
+
+  std::array<std::atomic<std::uint64_t>, bucket_count> buckets{};
+
+  void record(std::chrono::nanoseconds duration) {
+    auto ticks  = static_cast<std::uint64_t>(std::max<std::int64_t>(duration.count(), 0));
+    auto bucket = std::min<std::size_t>(std::bit_width(ticks), bucket_count - 1);
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+// upper bound of the latency of the fastest `fraction` of all samples in a histogram snapshot
+inline std::chrono::nanoseconds percentile(std::span<std::uint64_t const> buckets, double fraction) {
+  std::uint64_t total = 0;
+  for (auto count : buckets) {
+    total += count;
+  }
+
+  auto threshold     = static_cast<std::uint64_t>(fraction * double(total));
+  std::uint64_t seen = 0;
+  for (std::size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+    seen += buckets[bucket];
+    if (seen > 0 && seen >= threshold) {
+      return std::chrono::nanoseconds{std::int64_t{1} << bucket};
+    }
+  }
+  return std::chrono::nanoseconds{0};
+}
+
+struct MethodMetrics {
+  std::atomic<std::uint64_t> calls{0};
+  std::atomic<std::uint64_t> errors{0};
+  std::atomic<std::uint64_t> bytes_in{0};
+  std::atomic<std::uint64_t> bytes_out{0};
+  Histogram latency{};
+};
+
+// snapshot of the metrics of a single method
+struct MethodStats {
+  std::string_view name;
+  std::uint32_t opcode;
+  std::uint64_t calls;
+  std::uint64_t errors;
+  std::uint64_t bytes_in;
+  std::uint64_t bytes_out;
+  std::array<std::uint64_t, Histogram::bucket_count> latency;
+
+  [[nodiscard]] std::chrono::nanoseconds percentile(double fraction) const {
+    return rpc::percentile(latency, fraction);
+  }
+};
+
+namespace _metrics_impl {
+struct NamedOpcode {
+  std::uint32_t opcode;
+  char const* name;
+};
+
+// method names in the order of schema<Service>
+template <typename Service>
+constexpr inline auto names =
+    [:meta::expand(typename Service::policy{}.template remote_members<Service>()):] >> []<auto... Methods> {
+      auto methods = std::array<NamedOpcode, sizeof...(Methods)>{
+          NamedOpcode{opcode_of(Methods), std::define_static_string(identifier_of(Methods))}...};
+      std::ranges::sort(methods, {}, &NamedOpcode::opcode);
+      return methods;
+    };
+
+#if ERL_RPC_METRICS
+template <typename Service, Side S>
+inline std::array<MethodMetrics, schema<Service>.size()> registry{};
+
+template <typename Service>
+MethodMetrics* find(Side side, std::uint32_t opcode) {
+  auto position = find_method(schema<Service>, opcode);
+  if (position == schema<Service>.size()) {
+    return nullptr;
+  }
+  return side == Side::client ? &registry<Service, Side::client>[position]
+                              : &registry<Service, Side::server>[position];
+}
+#endif
+}  // namespace _metrics_impl
+
+// measures a single call until it goes out of scope
+// calls that are left by an exception count as errors
+// a batch of calls handled together counts every call, its latency is recorded once
+class Probe {
+#if ERL_RPC_METRICS
+  MethodMetrics* target;
+  std::chrono::steady_clock::time_point start;
+  int exceptions;
+  std::size_t count;
+
+  Probe(MethodMetrics* target, std::size_t count)
+      : target(target)
+      , start(std::chrono::steady_clock::now())
+      , exceptions(std::uncaught_exceptions())
+      , count(count) {}
+
+public:
+  template <typename Service>
+  static Probe start_call(Side side, std::uint32_t opcode, std::size_t count = 1) {
+    return Probe{_metrics_impl::find<Service>(side, opcode), count};
+  }
+
+  Probe(Probe const&)            = delete;
+  Probe& operator=(Probe const&) = delete;
+
+  ~Probe() {
+    if (target == nullptr) {
+      return;
+    }
+    target->calls.fetch_add(count, std::memory_order_relaxed);
+    if (std::uncaught_exceptions() > exceptions) {
+      target->errors.fetch_add(count, std::memory_order_relaxed);
+    }
+    target->latency.record(std::chrono::steady_clock::now() - start);
+  }
+
+  void received(std::size_t bytes) {
+    if (target != nullptr) {
+      target->bytes_in.fetch_add(bytes, std::memory_order_relaxed);
+    }
+  }
+
+  void sent(std::size_t bytes) {
+    if (target != nullptr) {
+      target->bytes_out.fetch_add(bytes, std::memory_order_relaxed);
+    }
+  }
+#else
+public:
+  template <typename Service>
+  static Probe start_call(Side, std::uint32_t, std::size_t = 1) {
+    return {};
+  }
+
+  void received(std::size_t) {}
+  void sent(std::size_t) {}
+#endif
+};
+
+// snapshot of the metrics of all methods of Service, sorted by opcode
+template <typename Service>
+std::vector<MethodStats> stats(Side side = Side::server) {
+  std::vector<MethodStats> result{};
+#if ERL_RPC_METRICS
+  auto const& methods = _metrics_impl::names<Service>;
+  for (std::size_t idx = 0; idx < methods.size(); ++idx) {
+    auto const& current = side == Side::client ? _metrics_impl::registry<Service, Side::client>[idx]
+                                               : _metrics_impl::registry<Service, Side::server>[idx];
+    auto& entry = result.emplace_back(MethodStats{.name      = methods[idx].name,
+                                                  .opcode    = methods[idx].opcode,
+                                                  .calls     = current.calls.load(std::memory_order_relaxed),
+                                                  .errors    = current.errors.load(std::memory_order_relaxed),
+                                                  .bytes_in  = current.bytes_in.load(std::memory_order_relaxed),
+                                                  .bytes_out = current.bytes_out.load(std::memory_order_relaxed),
+                                                  .latency   = {}});
+    for (std::size_t bucket = 0; bucket < Histogram::bucket_count; ++bucket) {
+      entry.latency[bucket] = current.latency.buckets[bucket].load(std::memory_order_relaxed);
+    }
+  }
+#endif
+  return result;
+}
+}  // namespace erl::rpc
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <experimental/meta>
+
+#include <erl/_impl/util/meta.hpp>
+
+namespace erl::rpc {
+namespace annotations {
+// calls to methods with higher priority are handled first by servers with multiple lanes
+// attach to a method or to the service to apply it to all of its methods
+struct Priority {
+  std::uint8_t level;
+};
+
+consteval Priority priority(std::uint8_t level) {
+  return {level};
+}
+}  // namespace annotations
+
+// priority of a method, the method annotation takes precedence over the service annotation
+template <typename Service, std::meta::info Meta = std::meta::info{}>
+consteval std::uint8_t priority_of() {
+  if (Meta != std::meta::info{}) {
+    if (auto method = annotation_of_type<annotations::Priority>(Meta); method) {
+      return method->level;
+    }
+  }
+
+  if (auto service = annotation_of_type<annotations::Priority>(^^Service); service) {
+    return service->level;
+  }
+  return 0;
+}
+
+// sends on the lane matching the priority of the method if the client has lanes, see net::LaneClient
+template <typename Service, std::meta::info Meta, typename C>
+void send_prioritized(C& client, auto const& message) {
+  if constexpr (requires { client.send(message, std::uint8_t{}); }) {
+    client.send(message, priority_of<Service, Meta>());
+  } else {
+    client.send(message);
+  }
+}
+}  // namespace erl::rpc
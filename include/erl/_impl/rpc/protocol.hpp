@@ -1,45 +1,265 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <cstring>
 #include <experimental/meta>
+#include <optional>
 #include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
 #include <erl/_impl/rpc/proxy.hpp>
+#include <erl/_impl/rpc/deadline.hpp>
+#include <erl/_impl/rpc/cache.hpp>
+#include <erl/_impl/rpc/priority.hpp>
 #include <erl/reflect>
 #include <erl/_impl/net/message/reader.hpp>
+#include <erl/_impl/util/compress.hpp>
 
 #include <print>
 
 namespace erl::rpc {
+// the call threw on the server, see net::ThreadedServer
+struct RemoteError : std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
 template <typename Client>
 struct BlockingCall : Client {
-  template <typename Service, typename R, typename... Args>
-  auto call(std::size_t index, Args&&... args) {
+  constexpr static bool expects_reply = true;
+
+  // per-method result of the schema handshake, empty if no handshake was done
+  std::vector<std::uint8_t> agreement{};
+  Mismatch on_mismatch = Mismatch::fallback;
+  // id of the call whose reply is awaited, 0 if its request carries none
+  std::uint32_t awaited = 0;
+  std::uint32_t last_id = 0;
+  // replies of rpc::cacheable methods
+  ResultCache cache{};
+  // streamed results served on this connection
+  StreamTable streams{};
+
+  // exchange method fingerprints with the server
+  // returns true if all methods agree
+  template <typename Service>
+  bool handshake(Mismatch policy = Mismatch::fallback) {
     using protocol = typename Service::protocol;
 
-    auto request = protocol::request(index, std::forward<Args>(args)...);
-    Client::send(request);
-    auto response = Client::recv();
-    return protocol::template read_response<R>(index, std::span<char const>{response});
+    awaited = 0;
+    Client::send(protocol::make_handshake(schema<Service>));
+    auto response = receive<protocol>({});
+    agreement     = protocol::template read_response<std::vector<std::uint8_t>>(protocol::handshake_opcode,
+                                                                             std::span<char const>{response});
+    on_mismatch   = policy;
+    return std::ranges::all_of(agreement, [](auto agreed) { return agreed != 0; });
+  }
+
+  template <typename Service, std::meta::info Meta, typename... Args>
+  auto make_request(std::uint32_t opcode, Args&&... args) {
+    using protocol = typename Service::protocol;
+    return protocol::template seal<Service, Meta>(encode_request<Service, Meta>(opcode, std::forward<Args>(args)...));
+  }
+
+  template <typename Service, std::meta::info Meta, typename... Args>
+  auto encode_request(std::uint32_t opcode, Args&&... args) {
+    using protocol = typename Service::protocol;
+
+    if (!agreement.empty()) {
+      // agreement is in the order of the local schema
+      auto position = find_method(schema<Service>, opcode);
+      bool agreed   = position < agreement.size() && agreement[position] != 0;
+      if constexpr (Meta != std::meta::info{}) {
+        if constexpr (is_raw_capable<Meta>) {
+          if (agreed) {
+            return protocol::template request_raw<Meta>(opcode, std::forward<Args>(args)...);
+          }
+        }
+      }
+
+      if (!agreed && on_mismatch == Mismatch::reject) {
+        throw std::runtime_error("Schema mismatch");
+      }
+    }
+    return protocol::request(opcode, std::forward<Args>(args)...);
+  }
+
+  // tags a request with a new call id if its caller may stop waiting for the reply
+  // the server echoes the id, so late replies to calls that timed out can be told apart
+  template <typename Protocol>
+  auto tag(typename Protocol::message_type request, CallOptions const& options = call_options()) {
+    awaited = 0;
+    if (!may_abandon(options)) {
+      return request;
+    }
+
+    if (++last_id == 0) {
+      // 0 marks untagged replies
+      ++last_id;
+    }
+    awaited = last_id;
+    return Protocol::set_sequence(std::move(request), awaited);
+  }
+
+  // waits for the reply to the last request, see rpc::CallScope
+  // replies to calls that stopped waiting earlier are dropped
+  template <typename Protocol>
+  auto receive(CallOptions const& options = call_options()) {
+    while (true) {
+      auto response = wait(options);
+      if (Protocol::sequence_of(std::span<char const>{response}) == awaited) {
+        return response;
+      }
+    }
+  }
+
+  template <typename Service, typename R, std::meta::info Meta = std::meta::info{}, typename... Args>
+  auto call(std::uint32_t opcode, Args&&... args) {
+    using protocol      = typename Service::protocol;
+    auto const& options = call_options();
+    check(options);
+
+    auto probe   = Probe::start_call<Service>(Side::client, opcode);
+    auto request = make_request<Service, Meta>(opcode, std::forward<Args>(args)...);
+
+    [[maybe_unused]] std::vector<char> key{};
+    if constexpr (is_cacheable<Meta>) {
+      static_assert(!is_oneway<Meta> && !is_streaming<Meta> && return_type_of(Meta) != ^^void,
+                    "Only methods returning a value can be cached");
+      auto encoded = std::span<char const>{request};
+      if (auto cached = cache.find(opcode, encoded); cached) {
+        return protocol::template read_response<R>(opcode, *cached);
+      }
+      key.assign(encoded.begin(), encoded.end());
+    }
+
+    if constexpr (!is_oneway<Meta>) {
+      if (options.has_deadline()) {
+        request = protocol::set_deadline(std::move(request), encode_deadline(options.deadline));
+      }
+      request = tag<protocol>(std::move(request), options);
+    }
+    probe.sent(std::span<char const>{request}.size());
+    send_prioritized<Service, Meta>(static_cast<Client&>(*this), request);
+    if constexpr (is_streaming<Meta>) {
+      // only the first frame is measured
+      using element_type = std::ranges::range_value_t<R>;
+      auto response      = receive<protocol>(options);
+      probe.received(std::span<char const>{response}.size());
+      observe<protocol>(response);
+      auto first =
+          protocol::template read_response<StreamFrame<element_type>>(opcode, std::span<char const>{response});
+      return StreamRange<BlockingCall, protocol, element_type>{
+          this, opcode, stream_window<Service, Meta>(), std::move(first)};
+    } else if constexpr (!is_oneway<Meta>) {
+      auto response = receive<protocol>(options);
+      release_connection();
+      probe.received(std::span<char const>{response}.size());
+      observe<protocol>(response);
+      auto result = protocol::template read_response<R>(opcode, std::span<char const>{response});
+      if constexpr (is_cacheable<Meta>) {
+        cache.store(opcode, key, std::span<char const>{response}, *annotation_of_type<annotations::Cacheable>(Meta));
+      }
+      return result;
+    } else {
+      release_connection();
+    }
   }
 
   template <typename Service>
   void handle(Service&& service, std::span<char const> message) {
     using protocol = typename std::remove_cvref_t<Service>::protocol;
 
+    auto scope = StreamScope{streams};
     auto reply = protocol::dispatch(std::forward<Service>(service), std::span<char const>{message});
+    if (std::span<char const>{reply}.empty()) {
+      // one-way call
+      return;
+    }
     Client::send(reply);
   }
+
+  // key under which consecutive requests can be handled together, see rpc::batched
+  template <typename Service>
+  static auto group_of(std::span<char const> message) {
+    return std::remove_cvref_t<Service>::protocol::template group_of<Service>(message);
+  }
+
+  template <typename Service, typename M>
+  void handle_group(Service&& service, std::span<M const> messages) {
+    using protocol = typename std::remove_cvref_t<Service>::protocol;
+
+    auto scope = StreamScope{streams};
+    for (auto const& reply : protocol::dispatch_group(std::forward<Service>(service), messages)) {
+      if (!std::span<char const>{reply}.empty()) {
+        Client::send(reply);
+      }
+    }
+  }
+
+private:
+  // pooled clients may hand their connection to another caller, see net::PoolClient
+  // streamed results keep it until the next call completes
+  void release_connection() {
+    if constexpr (requires(Client& client) { client.release(); }) {
+      Client::release();
+    }
+  }
+
+  template <typename Protocol>
+  void observe(auto const& response) {
+    if (auto epoch = Protocol::epoch_of(std::span<char const>{response}); epoch) {
+      cache.observe(*epoch);
+    }
+  }
+
+  static void check(CallOptions const& options) {
+    if (options.stop_token.stop_requested()) {
+      throw Cancelled("Call was cancelled");
+    }
+    if (options.has_deadline() && CallOptions::clock::now() >= options.deadline) {
+      throw DeadlineExceeded("Deadline exceeded");
+    }
+  }
+
+  static bool may_abandon(CallOptions const& options) {
+    if constexpr (requires { Client::recv(options.stop_token, options.deadline); }) {
+      return options.is_bounded();
+    }
+    return false;
+  }
+
+  auto wait(CallOptions const& options) {
+    if constexpr (requires { Client::recv(options.stop_token, options.deadline); }) {
+      if (options.is_bounded()) {
+        auto response = Client::recv(options.stop_token, options.deadline);
+        if (std::span<char const>{response}.empty()) {
+          check(options);
+        }
+        return response;
+      }
+    }
+    return Client::recv();
+  }
 };
 
 
 template <typename Client>
 struct EventCall : Client {
-  template <typename Service, typename R, typename... Args>
-  void call(std::size_t index, Args&&... args) {
+  constexpr static bool expects_reply = false;
+
+  template <typename Service, typename R, std::meta::info Meta = std::meta::info{}, typename... Args>
+  void call(std::uint32_t opcode, Args&&... args) {
     using protocol = typename Service::protocol;
+    static_assert(!is_streaming<Meta>, "Streamed results require a reply channel");
 
-    auto request = protocol::request(index, std::forward<Args>(args)...);
-    Client::send(request);
+    auto probe   = Probe::start_call<Service>(Side::client, opcode);
+    auto request = protocol::template seal<Service, Meta>(protocol::request(opcode, std::forward<Args>(args)...));
+    probe.sent(std::span<char const>{request}.size());
+    send_prioritized<Service, Meta>(static_cast<Client&>(*this), request);
   }
 
   template <typename Service>
@@ -48,55 +268,573 @@ struct EventCall : Client {
 
     protocol::dispatch(std::forward<Service>(service), std::span<char const>{message});
   }
+
+  template <typename Service>
+  static auto group_of(std::span<char const> message) {
+    return std::remove_cvref_t<Service>::protocol::template group_of<Service>(message);
+  }
+
+  template <typename Service, typename M>
+  void handle_group(Service&& service, std::span<M const> messages) {
+    using protocol = typename std::remove_cvref_t<Service>::protocol;
+
+    protocol::dispatch_group(std::forward<Service>(service), messages);
+  }
 };
 
-template <typename MsgType>
+// Encoding selects the wire format of arguments and return values, see erl::encoding
+// the index is always sent at full width
+template <typename MsgType, typename Encoding = encoding::Fixed>
 struct RPCProtocol {
-  using message_type = MsgType;
-  using index_type   = std::uint32_t;
+  using message_type  = MsgType;
+  using index_type    = std::uint32_t;
+  using encoding_type = Encoding;
 
-  template <typename... Args>
-  static message_type request(index_type index, Args&&... args) {
+  // the upper bits of the index are reserved for flags, see opcode_of
+  constexpr static index_type opcode_mask      = 0x00FF'FFFF;
+  constexpr static index_type handshake_opcode = opcode_limit;
+
+  struct flags {
+    // arguments are raw object representations, see is_raw_capable
+    constexpr static index_type raw = 1U << 31;
+    // payload is LZ compressed and prefixed with its uncompressed size
+    constexpr static index_type compressed = 1U << 30;
+    // payload is a sequence of complete messages, each prefixed with its size
+    constexpr static index_type batch = 1U << 29;
+    // asks for the next window of a streamed result, see StreamRange
+    constexpr static index_type stream = 1U << 28;
+    // payload is prefixed with the caller's deadline, see rpc::CallScope
+    // in replies the flag marks requests that expired before they were dispatched
+    constexpr static index_type deadline = 1U << 27;
+    // reply is prefixed with the cache epoch of the service, see rpc::invalidate
+    constexpr static index_type epoch = 1U << 26;
+    // payload is prefixed with the caller's call id, replies echo it, see BlockingCall::tag
+    // the id always directly follows the index
+    constexpr static index_type sequence = 1U << 25;
+    // reply of a call that threw, the payload is the reason
+    constexpr static index_type error = 1U << 24;
+  };
+
+  // sets flag and inserts value between the index and the payload
+  template <typename T>
+  static message_type prepend(message_type message, index_type flag, T value) {
+    auto reader = message::MessageView{std::span<char const>{message}};
+    auto index  = erl::deserialize<index_type>(reader);
+    auto rest   = reader.remaining();
+
+    auto result = message_type{};
+    result.reserve(sizeof(index_type) + sizeof(T) + rest.size());
+    erl::serialize(index_type(index | flag), result);
+    erl::serialize(value, result);
+    result.write(rest.data(), rest.size());
+    return result;
+  }
+
+  static message_type set_deadline(message_type message, std::int64_t deadline) {
+    return prepend(std::move(message), flags::deadline, deadline);
+  }
+
+  // must be applied last, see flags::sequence
+  static message_type set_sequence(message_type message, std::uint32_t id) {
+    return prepend(std::move(message), flags::sequence, id);
+  }
+
+  // call id of a message, 0 if it carries none
+  static std::uint32_t sequence_of(std::span<char const> message) {
+    if (message.size() < sizeof(index_type) + sizeof(std::uint32_t)) {
+      return 0;
+    }
+    auto reader = message::MessageView{message};
+    auto index  = erl::deserialize<index_type>(reader);
+    if ((index & flags::sequence) == 0) {
+      return 0;
+    }
+    return erl::deserialize<std::uint32_t>(reader);
+  }
+
+  // copy of a request without its deadline, empty if it has none
+  static std::optional<message_type> clear_deadline(std::span<char const> message) {
+    if (message.size() < sizeof(index_type)) {
+      return std::nullopt;
+    }
+    auto reader = message::MessageView{message};
+    auto index  = erl::deserialize<index_type>(reader);
+    if (!has_prefix(index, flags::deadline, sizeof(std::int64_t), message.size())) {
+      return std::nullopt;
+    }
+
+    auto result = message_type{};
+    result.reserve(message.size() - sizeof(std::int64_t));
+    erl::serialize(index_type(index & ~flags::deadline), result);
+    if ((index & flags::sequence) != 0) {
+      erl::serialize(erl::deserialize<std::uint32_t>(reader), result);
+    }
+    erl::deserialize<std::int64_t>(reader);
+    auto rest = reader.remaining();
+    result.write(rest.data(), rest.size());
+    return result;
+  }
+
+  static std::optional<std::uint64_t> epoch_of(std::span<char const> message) {
+    if (message.size() < sizeof(index_type)) {
+      return std::nullopt;
+    }
+    auto reader = message::MessageView{message};
+    auto index  = erl::deserialize<index_type>(reader);
+    if (!has_prefix(index, flags::epoch, sizeof(std::uint64_t), message.size())) {
+      return std::nullopt;
+    }
+    skip_sequence(index, reader);
+    return erl::deserialize<std::uint64_t>(reader);
+  }
+
+  // true if flag is set and the message is large enough to hold the prefix it announces
+  static bool has_prefix(index_type index, index_type flag, std::size_t prefix, std::size_t size) {
+    auto sequence = (index & flags::sequence) != 0 ? sizeof(std::uint32_t) : 0;
+    return (index & flag) != 0 && size >= sizeof(index_type) + sequence + prefix;
+  }
+
+  static void skip_sequence(index_type index, message::MessageView& reader) {
+    if ((index & flags::sequence) != 0) {
+      reader.read(sizeof(std::uint32_t));
+    }
+  }
+
+  // cache epoch to stamp the reply of a call with, must be read before the call runs
+  // a reply computed from data that was invalidated meanwhile then carries the old epoch
+  template <typename S>
+  static std::uint64_t epoch_before_call() {
+    if constexpr (has_cacheable_methods<std::remove_cvref_t<S>>()) {
+      return cache_epoch<std::remove_cvref_t<S>>();
+    }
+    return 0;
+  }
+
+  // stamps replies of services with cacheable methods, one-way calls have no reply
+  template <typename S>
+  static message_type stamp(message_type reply, std::uint64_t epoch) {
+    if constexpr (has_cacheable_methods<std::remove_cvref_t<S>>()) {
+      if (!std::span<char const>{reply}.empty()) {
+        return prepend(std::move(reply), flags::epoch, epoch);
+      }
+    }
+    return reply;
+  }
+
+  static message_type expired(index_type opcode) { return encode(index_type(opcode | flags::deadline)); }
+
+  // reply to a request whose call threw, read_response rethrows it as RemoteError
+  static message_type fail(std::span<char const> request, std::string_view reason) {
+    if (request.size() < sizeof(index_type)) {
+      return encode(flags::error, std::string{reason});
+    }
+
+    auto reader = message::MessageView{request};
+    auto index  = erl::deserialize<index_type>(reader);
+    auto reply  = encode(index_type((index & opcode_mask) | flags::error), std::string{reason});
+    if (auto id = sequence_of(request); id != 0) {
+      return set_sequence(std::move(reply), id);
+    }
+    return reply;
+  }
+
+  // a window of 0 closes the stream
+  static message_type request_credit(index_type opcode, std::uint64_t stream, std::uint32_t window) {
+    return encode(index_type(opcode | flags::stream), stream, window);
+  }
+
+  // concatenates finished messages into a single batch message
+  static message_type make_batch(std::span<message_type const> messages) {
+    std::size_t total = sizeof(index_type) + sizeof(std::uint32_t);
+    for (auto const& message : messages) {
+      total += sizeof(std::uint32_t) + std::span<char const>{message}.size();
+    }
+
+    auto result = message_type{};
+    result.reserve(total);
+    erl::serialize(flags::batch, result);
+    erl::serialize(static_cast<std::uint32_t>(messages.size()), result);
+    for (auto const& message : messages) {
+      auto data = std::span<char const>{message};
+      erl::serialize(static_cast<std::uint32_t>(data.size()), result);
+      result.write(data.data(), data.size());
+    }
+    return result;
+  }
+
+  // messages contained in the payload of a batch message
+  static std::vector<std::span<char const>> read_batch(std::span<char const> payload) {
+    auto reader = message::MessageView{payload};
+    auto count  = erl::deserialize<std::uint32_t>(reader);
+
+    auto messages = std::vector<std::span<char const>>{};
+    messages.reserve(count);
+    for (std::uint32_t idx = 0; idx < count; ++idx) {
+      auto size = erl::deserialize<std::uint32_t>(reader);
+      messages.push_back(reader.read(size));
+    }
+    return messages;
+  }
+
+  // replies contained in the reply to a batch message
+  static std::vector<std::span<char const>> read_batch_reply(std::span<char const> reply) {
+    auto reader = message::MessageView{reply};
+    // batches have no opcode
+    reply_index(reader, 0);
+    return read_batch(reader.remaining());
+  }
+
+  // compresses the payload if it exceeds threshold and compression actually saves space
+  static message_type compress(message_type message, std::size_t threshold) {
+    auto data = std::span<char const>{message};
+    if (data.size() < sizeof(index_type) + threshold) {
+      return message;
+    }
+
+    auto reader  = message::MessageView{data};
+    auto index   = erl::deserialize<index_type>(reader);
+    auto payload = reader.remaining();
+
+    auto scratch         = std::vector<char>(util::lz::compress_bound(payload.size()));
+    auto compressed_size = util::lz::compress(payload, scratch.data());
+    if (compressed_size + sizeof(std::uint32_t) >= payload.size()) {
+      return message;
+    }
+
+    auto result = message_type{};
+    result.reserve(sizeof(index_type) + sizeof(std::uint32_t) + compressed_size);
+    erl::serialize(index_type(index | flags::compressed), result);
+    erl::serialize(static_cast<std::uint32_t>(payload.size()), result);
+    result.write(scratch.data(), compressed_size);
+    return result;
+  }
+
+  // applies per-service or per-method transformations to a finished message
+  template <typename Service, std::meta::info Meta = std::meta::info{}>
+  static message_type seal(message_type message) {
+    if constexpr (constexpr auto threshold = compression_threshold<Service, Meta>(); threshold != 0) {
+      return compress(std::move(message), threshold);
+    }
+    return message;
+  }
+
+  // payload following the index, decompressed into storage if necessary
+  static std::span<char const> payload_of(index_type index, std::span<char const> remainder,
+                                          std::vector<char>& storage) {
+    if ((index & flags::compressed) == 0) {
+      return remainder;
+    }
+
+    auto reader = message::MessageView{remainder};
+    auto size   = erl::deserialize<std::uint32_t>(reader);
+    // the size is untrusted, do not allocate more than the block can expand to
+    if (size > util::lz::max_decompressed_size(reader.remaining().size())) {
+      throw std::runtime_error("Malformed compressed message");
+    }
+    storage.resize(size);
+    if (!util::lz::decompress(reader.remaining(), storage)) {
+      throw std::runtime_error("Malformed compressed message");
+    }
+    return storage;
+  }
+
+  static auto reader(std::span<char const> data) {
+    if constexpr (std::same_as<Encoding, encoding::Fixed>) {
+      return message::MessageView{data};
+    } else {
+      return Encoded<Encoding, message::MessageView>{{data}};
+    }
+  }
+
+  template <typename... Ts>
+  static message_type encode(index_type index, Ts&&... values) {
     auto message = message_type{};
-    erl::serialize(index, message);
-    (erl::serialize(std::forward<Args>(args), message), ...);
+    if constexpr (std::same_as<Encoding, encoding::Fixed> && (is_fixed_size<Ts> && ...)) {
+      // size is known at compile time - stage the whole message and copy it in one go
+      auto staging = message::FixedBuffer<sizeof(index_type) + (fixed_size_of<Ts> + ... + 0UZ)>{};
+      erl::serialize(index, staging);
+      (erl::serialize(std::forward<Ts>(values), staging), ...);
+      message.reserve(staging.size());
+      message.write(staging.data(), staging.size());
+    } else {
+      message.reserve(sizeof(index_type) + (erl::serialized_size<Encoding>(values) + ... + 0UZ));
+      erl::serialize(index, message);
+      auto writer = Encoded<Encoding, message_type&>{message};
+      (erl::serialize(std::forward<Ts>(values), writer), ...);
+    }
     return message;
   }
 
+  template <typename... Args>
+  static message_type request(index_type index, Args&&... args) {
+    return encode(index, std::forward<Args>(args)...);
+  }
+
   template <typename... Args>
   static message_type request(index_type index, message_type payload) {
     auto message = message_type{};
+    message.reserve(sizeof(index_type) + payload.size());
     erl::serialize(index, message);
-    message.reserve(payload.size());
     message.write(payload.finalize());
     return message;
   }
 
+  template <std::meta::info Meta, typename... Args>
+  static message_type request_raw(index_type index, Args&&... args) {
+    return [:meta::expand(parameters_of(Meta)):] >> [&]<auto... Params> {
+      auto message = message_type{};
+      message.reserve(sizeof(index_type) + (sizeof([:remove_cvref(type_of(Params)):]) + ... + 0UZ));
+      erl::serialize(index_type(index | flags::raw), message);
+      (write_raw<[:remove_cvref(type_of(Params)):]>(message, std::forward<Args>(args)), ...);
+      return message;
+    };
+  }
+
+  // padding is sent as zeros instead of whatever the caller's stack held
+  template <typename T>
+  static void write_raw(message_type& message, T const& value) {
+    if constexpr (std::has_unique_object_representations_v<T>) {
+      message.write(&value, sizeof(T));
+    } else {
+      std::array<char, sizeof(T)> bytes{};
+      copy_value(value, bytes.data());
+      message.write(bytes.data(), bytes.size());
+    }
+  }
+
+  // copies the value representation of value to out, leaves padding bytes untouched
+  template <typename T>
+  static void copy_value(T const& value, char* out) {
+    if constexpr (std::has_unique_object_representations_v<T> || std::is_scalar_v<T> || std::is_union_v<T>) {
+      std::memcpy(out, &value, sizeof(T));
+    } else if constexpr (std::is_array_v<T>) {
+      for (std::size_t idx = 0; idx < std::extent_v<T>; ++idx) {
+        copy_value(value[idx], out + idx * sizeof(value[0]));
+      }
+    } else {
+      [:meta::expand(bases_of(^^T)):] >>= [&]<auto Base>() {
+        copy_value(static_cast<[:type_of(Base):] const&>(value), out + offset_of(Base).bytes);
+      };
+      [:meta::expand(nonstatic_data_members_of(^^T)):] >>= [&]<auto Member>() {
+        if constexpr (is_bit_field(Member)) {
+          // bit-fields are allocated from the least significant bit on little endian targets
+          auto bits     = static_cast<std::uint64_t>(value.[:Member:]);
+          auto position = offset_of(Member).bytes * 8 + offset_of(Member).bits;
+          for (std::size_t bit = 0; bit < bit_size_of(Member); ++bit, ++position) {
+            if (((bits >> bit) & 1U) != 0) {
+              out[position / 8] = char(out[position / 8] | (1U << (position % 8)));
+            }
+          }
+        } else {
+          copy_value(value.[:Member:], out + offset_of(Member).bytes);
+        }
+      };
+    }
+  }
+
+  template <std::size_t N>
+  static message_type make_handshake(std::array<MethodSchema, N> const& methods) {
+    return encode(handshake_opcode, std::vector<MethodSchema>(methods.begin(), methods.end()));
+  }
+
+  // methods are matched by opcode, the reply follows the order of the client's schema
+  template <typename S>
+  static message_type accept_handshake(std::span<char const> payload) {
+    auto reader       = RPCProtocol::reader(payload);
+    auto remote       = erl::deserialize<std::vector<MethodSchema>>(reader);
+    auto const& local = schema<std::remove_cvref_t<S>>;
+
+    auto agreement = std::vector<std::uint8_t>(remote.size());
+    for (std::size_t idx = 0; idx < remote.size(); ++idx) {
+      auto position  = find_method(local, remote[idx].opcode);
+      agreement[idx] = position < local.size() && local[position].fingerprint == remote[idx].fingerprint;
+    }
+    return make_response(handshake_opcode, agreement);
+  }
+
   template <typename S>
   static message_type dispatch(S&& service, std::span<char const> message) {
-    auto reader                      = erl::message::MessageView{message};
-    auto index                       = erl::deserialize<index_type>(reader);
-    auto remainder                   = reader.buffer.subspan(reader.cursor);
+    auto reader = erl::message::MessageView{message};
+    auto index  = erl::deserialize<index_type>(reader);
+    if ((index & flags::sequence) == 0) {
+      return dispatch_call(std::forward<S>(service), index, reader);
+    }
+
+    if (message.size() < sizeof(index_type) + sizeof(std::uint32_t)) {
+      throw std::runtime_error("Malformed message");
+    }
+    auto id    = erl::deserialize<std::uint32_t>(reader);
+    auto reply = dispatch_call(std::forward<S>(service), index & ~flags::sequence, reader);
+    if (std::span<char const>{reply}.empty()) {
+      // one-way call
+      return reply;
+    }
+    return set_sequence(std::move(reply), id);
+  }
+
+  template <typename S>
+  static message_type dispatch_call(S&& service, index_type index, message::MessageView reader) {
+    if ((index & flags::deadline) != 0 && is_expired(erl::deserialize<std::int64_t>(reader))) {
+      // the caller no longer waits for the result
+      return expired(index & opcode_mask);
+    }
+
+    if ((index & flags::batch) != 0) {
+      // calls are executed in order, replies are batched the same way
+      auto requests = read_batch(reader.remaining());
+      auto replies  = std::vector<message_type>{};
+      replies.reserve(requests.size());
+      for (auto request : requests) {
+        replies.push_back(RPCProtocol::dispatch(service, request));
+      }
+      return make_batch(replies);
+    }
+
+    auto opcode                      = index & opcode_mask;
+    auto storage                     = std::vector<char>{};
+    auto remainder                   = payload_of(index, reader.remaining(), storage);
+    constexpr static auto dispatcher = erl::rpc::Dispatcher<S, RPCProtocol>{};
+
+    if (opcode == handshake_opcode) {
+      return accept_handshake<S>(remainder);
+    }
+
+    auto epoch = epoch_before_call<S>();
+    if ((index & flags::stream) != 0) {
+      return stamp<S>(dispatcher.stream(std::forward<S>(service), opcode, remainder), epoch);
+    }
+
+    if ((index & flags::raw) != 0) {
+      return stamp<S>(dispatcher.raw(std::forward<S>(service), opcode, remainder), epoch);
+    }
+    return stamp<S>(dispatcher(std::forward<S>(service), opcode, remainder), epoch);
+  }
+
+  // key of a request that may be handled together with consecutive requests of the same method
+  // empty if the method has no batch handler, see rpc::batched
+  template <typename S>
+  static std::optional<index_type> group_of(std::span<char const> message) {
+    if (message.size() < sizeof(index_type)) {
+      return std::nullopt;
+    }
+
+    auto reader = erl::message::MessageView{message};
+    auto index  = erl::deserialize<index_type>(reader);
+    auto opcode = index & opcode_mask;
+    // replies to tagged calls echo their id, see flags::sequence
+    if ((index & (flags::batch | flags::stream | flags::deadline | flags::sequence)) != 0 ||
+        opcode == handshake_opcode ||
+        !erl::rpc::Dispatcher<S, RPCProtocol>::is_batched(opcode)) {
+      return std::nullopt;
+    }
+    // compression is decided per message
+    return index & ~flags::compressed;
+  }
+
+  // requests of the same group, passed to the batch handler of their method in one call
+  template <typename S>
+  static std::vector<message_type> dispatch_group(S&& service, std::span<message_type const> messages) {
+    auto storage  = std::vector<std::vector<char>>(messages.size());
+    auto payloads = std::vector<std::span<char const>>{};
+    payloads.reserve(messages.size());
+
+    index_type index = 0;
+    for (std::size_t idx = 0; idx < messages.size(); ++idx) {
+      auto reader = erl::message::MessageView{std::span<char const>{messages[idx]}};
+      index       = erl::deserialize<index_type>(reader);
+      payloads.push_back(payload_of(index, reader.remaining(), storage[idx]));
+    }
+
+    auto replies                     = std::vector<message_type>{};
+    constexpr static auto dispatcher = erl::rpc::Dispatcher<S, RPCProtocol>{};
+    auto epoch                       = epoch_before_call<S>();
+    dispatcher.dispatch_batch(service, index & opcode_mask, payloads, (index & flags::raw) != 0, replies);
+    for (auto& reply : replies) {
+      reply = stamp<S>(std::move(reply), epoch);
+    }
+    return replies;
+  }
+
+  // concurrency requirements of a request, see net::ThreadedServer
+  template <typename S>
+  static CallInfo describe(S&& service, std::span<char const> message) {
+    auto reader = erl::message::MessageView{message};
+    auto index  = erl::deserialize<index_type>(reader);
+    auto opcode = index & opcode_mask;
+
+    skip_sequence(index, reader);
+    if ((index & flags::deadline) != 0) {
+      reader.read(sizeof(std::int64_t));
+    }
+    if ((index & (flags::batch | flags::stream)) != 0) {
+      // may contain any call or resume a generator of any method
+      return {Concurrency::exclusive};
+    }
+    if (opcode == handshake_opcode) {
+      return {Concurrency::concurrent};
+    }
+
+    auto storage                     = std::vector<char>{};
+    auto remainder                   = payload_of(index, reader.remaining(), storage);
     constexpr static auto dispatcher = erl::rpc::Dispatcher<S, RPCProtocol>{};
-    return dispatcher(std::forward<S>(service), index, remainder);
+    return dispatcher.describe(std::forward<S>(service), opcode, remainder, (index & flags::raw) != 0);
   }
 
   template <typename... Ts>
   static message_type make_response(index_type index, Ts&&... value) {
-    auto message = message_type{};
-    erl::serialize(index, message);
-    (erl::serialize(std::forward<Ts>(value), message), ...);
-    return message;
+    return encode(index, std::forward<Ts>(value)...);
+  }
+
+  // index of a reply, leaves reader after its call id
+  // replies are matched at runtime, a mismatch means the connection is out of sync
+  static index_type reply_index(message::MessageView& reader, index_type expected_index) {
+    if (reader.remaining().size() < sizeof(index_type)) {
+      throw std::runtime_error("Reply does not belong to the call");
+    }
+    auto index = erl::deserialize<index_type>(reader);
+    if ((index & opcode_mask) != expected_index) {
+      throw std::runtime_error("Reply does not belong to the call");
+    }
+    skip_sequence(index, reader);
+    if ((index & flags::error) != 0) {
+      auto payload = RPCProtocol::reader(reader.remaining());
+      throw RemoteError(erl::deserialize<std::string>(payload));
+    }
+    return index;
   }
 
   template <typename T>
   static T read_response(index_type expected_index, std::span<char const> message) {
     auto reader = erl::message::MessageView{message};
-    auto index  = erl::deserialize<index_type>(reader);
-    assert(index == expected_index);
+    auto index  = reply_index(reader, expected_index);
+    if ((index & flags::deadline) != 0) {
+      throw DeadlineExceeded("Deadline exceeded before dispatch");
+    }
+    if ((index & flags::epoch) != 0) {
+      erl::deserialize<std::uint64_t>(reader);
+    }
     if constexpr (!std::same_as<T, void>) {
-      return erl::deserialize<T>(reader);
+      auto storage = std::vector<char>{};
+      auto payload = RPCProtocol::reader(payload_of(index, reader.remaining(), storage));
+      return erl::deserialize<T>(payload);
     }
   }
+
+  // like read_response, but reuses the memory owned by result
+  template <typename T>
+  static void read_response_into(index_type expected_index, std::span<char const> message, T& result) {
+    auto reader = erl::message::MessageView{message};
+    auto index  = reply_index(reader, expected_index);
+    if ((index & flags::deadline) != 0) {
+      throw DeadlineExceeded("Deadline exceeded before dispatch");
+    }
+    if ((index & flags::epoch) != 0) {
+      erl::deserialize<std::uint64_t>(reader);
+    }
+
+    auto storage = std::vector<char>{};
+    auto payload = RPCProtocol::reader(payload_of(index, reader.remaining(), storage));
+    erl::deserialize_into(result, payload);
+  }
 };
 }
\ No newline at end of file
@@ -1,18 +1,26 @@
 #pragma once
+#include <array>
+#include <bit>
 #include <cassert>
 #include <cstddef>
+#include <cstring>
+#include <tuple>
 #include <type_traits>
 #include <vector>
 #include <concepts>
 #include <ranges>
+#include <span>
+#include <stdexcept>
 #include <experimental/meta>
 
 #include <erl/reflect>
+#include <erl/_impl/util/hash.hpp>
 #include <erl/_impl/util/meta.hpp>
-#include <erl/_impl/util/stamp.hpp>
 #include <erl/_impl/net/message/buffer.hpp>
 #include <erl/_impl/net/message/reader.hpp>
 #include "dispatch.hpp"
+#include "schema.hpp"
+#include "concurrency.hpp"
 
 namespace erl::rpc {
 namespace annotations {
@@ -32,9 +40,55 @@ consteval Handler handler(std::meta::info fnc) {
 
 struct CallbackTag {
 } constexpr inline callback{};
+
+// consecutive calls that are queued on the server may be passed to `fnc` at once
+// fnc takes std::span<Arg> for methods with a single parameter, std::span<std::tuple<Args...>> otherwise
+// it returns void or one result per call as a range
+struct Batched {
+  std::meta::info fnc;
+};
+
+consteval Batched batched(std::meta::info fnc) {
+  return {fnc};
+}
+
+// compress messages whose payload exceeds `threshold` bytes
+// attach to a method or to the service to apply it to all of its methods
+struct Compress {
+  std::uint32_t threshold;
+
+  consteval Compress operator()(std::uint32_t threshold) const { return {threshold}; }
+};
+constexpr inline Compress compress{512};
+
+// decode arguments into per-thread objects that are reused across calls
+// take parameters by const reference to benefit, by-value parameters are still copied
+struct ReuseArgumentsTag {
+} constexpr inline reuse_arguments{};
 }  // namespace annotations
 
-template <typename Service, int Idx, typename Super, typename R>
+// compression threshold of a method, 0 if compression is disabled
+template <typename Service, std::meta::info Meta = std::meta::info{}>
+consteval std::uint32_t compression_threshold() {
+  if (Meta != std::meta::info{}) {
+    if (auto method = annotation_of_type<annotations::Compress>(Meta); method) {
+      return method->threshold;
+    }
+  }
+
+  if (auto service = annotation_of_type<annotations::Compress>(^^Service); service) {
+    return service->threshold;
+  }
+  return 0;
+}
+
+template <typename Service, std::meta::info Meta>
+consteval bool reuses_arguments() {
+  return meta::has_annotation<annotations::ReuseArgumentsTag>(Meta) ||
+         meta::has_annotation<annotations::ReuseArgumentsTag>(^^Service);
+}
+
+template <typename Service, int Idx, typename Super, typename R, std::meta::info Meta>
 struct FunctionProxy {
   template <typename... Ts>
   decltype(auto) operator()(Ts&&... args) const {
@@ -44,30 +98,227 @@ struct FunctionProxy {
 
     // first (unnamed) member of Proxy is a pointer to the actual handler
     auto* handler = that->[:meta::get_nth_member(^^Super, 0):];
-    return handler->template call<Service, R>(Idx, std::forward<Ts>(args)...);
+    return handler->template call<Service, R, Meta>(opcode_of(Meta), std::forward<Ts>(args)...);
   }
 };
 
-template <std::meta::info Meta, int Idx, typename Protocol>
+template <std::meta::info Meta, std::uint32_t Opcode, typename Protocol>
 struct FunctionDispatcher {
+  static_assert(!is_oneway<Meta> || return_type_of(Meta) == ^^void, "One-way methods must return void");
+  static_assert(!is_streaming<Meta> || std::ranges::none_of(parameters_of(Meta),
+                                                            [](auto param) { return is_reference_type(type_of(param)); }),
+                "Streaming methods must take parameters by value, the generator outlives the call");
+  static_assert(!is_streaming<Meta> || !meta::has_annotation<annotations::Batched>(Meta),
+                "Streaming methods cannot have a batch handler");
+  constexpr static std::uint32_t opcode    = Opcode;
+  constexpr static Concurrency concurrency = concurrency_of<[:parent_of(Meta):], Meta>();
+  constexpr static bool batched            = meta::has_annotation<annotations::Batched>(Meta);
+
+  // offsets of the arguments of a raw encoded call
+  constexpr static auto raw_offsets = [:meta::expand(parameters_of(Meta)):] >> []<auto... Params> {
+    std::array<std::size_t, sizeof...(Params)> sizes{sizeof([:remove_cvref(type_of(Params)):])...};
+    std::array<std::size_t, sizeof...(Params)> result{};
+    for (std::size_t idx = 1; idx < sizes.size(); ++idx) {
+      result[idx] = result[idx - 1] + sizes[idx - 1];
+    }
+    return result;
+  };
+  constexpr static std::size_t raw_size = [:meta::expand(parameters_of(Meta)):] >> []<auto... Params> {
+    return (sizeof([:remove_cvref(type_of(Params)):]) + ... + 0UZ);
+  };
+
+  // raw arguments are read at fixed offsets, the payload must match the layout exactly
+  static void check_raw(std::span<char const> data) {
+    if (data.size() != raw_size) {
+      throw std::invalid_argument("Malformed raw arguments");
+    }
+  }
+
   template <typename Obj>
     requires(parent_of(Meta) == remove_cvref(^^Obj))
   static constexpr decltype(auto) eval(Obj&& obj, std::span<char const> data) {
-    auto args = message::MessageView{data};
+    auto args = Protocol::reader(data);
     return [:meta::expand(parameters_of(Meta)):] >> [&]<auto... Params> {
-      return (std::forward<Obj>(obj).[:Meta:])(deserialize<[:type_of(Params):]>(args)...);
+      using arguments = std::tuple<[:remove_cvref(type_of(Params)):]...>;
+      if constexpr (reuses_arguments<[:parent_of(Meta):], Meta>()) {
+        thread_local arguments storage{};
+        std::apply([&](auto&... values) { (erl::deserialize_into(values, args), ...); }, storage);
+        return std::apply(
+            [&](auto&... values) -> decltype(auto) { return (std::forward<Obj>(obj).[:Meta:])(values...); },
+            storage);
+      } else {
+        // braced initialization reads the arguments left to right
+        return std::apply(
+            [&](auto&&... values) -> decltype(auto) {
+              return (std::forward<Obj>(obj).[:Meta:])(std::forward<decltype(values)>(values)...);
+            },
+            arguments{erl::deserialize<[:type_of(Params):]>(args)...});
+      }
     };
   }
 
+  template <typename... Ts>
+  static Protocol::message_type respond(Ts&&... values) {
+    return Protocol::template seal<[:parent_of(Meta):], Meta>(Protocol::make_response(Opcode, std::forward<Ts>(values)...));
+  }
+
   template <typename Obj>
   static constexpr Protocol::message_type dispatch(Obj&& obj, std::span<char const> data) {
-    if constexpr (return_type_of(Meta) == ^^void) {
+    if constexpr (is_oneway<Meta>) {
+      eval(std::forward<Obj>(obj), data);
+      // empty messages are not sent, see BlockingCall::handle
+      return {};
+    } else if constexpr (is_streaming<Meta>) {
+      // reply with the first window, the client asks for the rest
+      // the stream belongs to the connection the call arrived on
+      auto& streams = current_streams();
+      return respond(streams.open(eval(std::forward<Obj>(obj), data), stream_window<[:parent_of(Meta):], Meta>()));
+    } else if constexpr (return_type_of(Meta) == ^^void) {
       eval(std::forward<Obj>(obj), data);
-      return Protocol::make_response(Idx);
+      return respond();
+    } else {
+      return respond(eval(std::forward<Obj>(obj), data));
+    }
+  }
+
+  template <typename Obj>
+    requires(is_streaming<Meta>)
+  static Protocol::message_type dispatch_stream(Obj&&, std::span<char const> data) {
+    auto args   = Protocol::reader(data);
+    auto id     = erl::deserialize<std::uint64_t>(args);
+    auto window = erl::deserialize<std::uint32_t>(args);
+    return respond(current_streams().template resume<[:return_type_of(Meta):]>(id, window));
+  }
+
+  template <typename T>
+  static T read_raw(std::span<char const> data, std::size_t offset) {
+    std::array<char, sizeof(T)> bytes;
+    std::memcpy(bytes.data(), data.data() + offset, sizeof(T));
+    return std::bit_cast<T>(bytes);
+  }
+
+  template <typename Obj>
+    requires(is_raw_capable<Meta>)
+  static constexpr Protocol::message_type dispatch_raw(Obj&& obj, std::span<char const> data) {
+    check_raw(data);
+    auto invoke = [&] {
+      return [:meta::expand(parameters_of(Meta)):] >> [&]<auto... Params> {
+        // offsets are known up front, read order does not matter
+        return [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+          return (std::forward<Obj>(obj).[:Meta:])(
+              read_raw<[:remove_cvref(type_of(Params...[Is])):]>(data, raw_offsets[Is])...);
+        }(std::make_index_sequence<sizeof...(Params)>{});
+      };
+    };
+
+    if constexpr (is_oneway<Meta>) {
+      invoke();
+      return {};
+    } else if constexpr (return_type_of(Meta) == ^^void) {
+      invoke();
+      return respond();
+    } else {
+      return respond(invoke());
+    }
+  }
+
+  // decodes the arguments of a single call into the element type of the batch handler
+  static auto decode(std::span<char const> data, bool raw) {
+    return [:meta::expand(parameters_of(Meta)):] >> [&]<auto... Params> {
+      using arguments = std::tuple<[:remove_cvref(type_of(Params)):]...>;
+      auto values     = [&] {
+        if (raw) {
+          check_raw(data);
+          return [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+            return arguments{read_raw<[:remove_cvref(type_of(Params...[Is])):]>(data, raw_offsets[Is])...};
+          }(std::make_index_sequence<sizeof...(Params)>{});
+        }
+        auto args = Protocol::reader(data);
+        return arguments{erl::deserialize<[:remove_cvref(type_of(Params)):]>(args)...};
+      }();
+
+      if constexpr (sizeof...(Params) == 1) {
+        return std::get<0>(std::move(values));
+      } else {
+        return values;
+      }
+    };
+  }
+
+  template <typename Obj>
+    requires(batched)
+  static std::vector<typename Protocol::message_type> dispatch_batch(Obj&& obj,
+                                                                     std::span<std::span<char const> const> payloads,
+                                                                     bool raw) {
+    constexpr auto handler = annotation_of_type<annotations::Batched>(Meta)->fnc;
+    using element_type     = decltype(decode({}, false));
+
+    auto calls = std::vector<element_type>{};
+    calls.reserve(payloads.size());
+    for (auto payload : payloads) {
+      calls.push_back(decode(payload, raw));
+    }
+
+    auto replies = std::vector<typename Protocol::message_type>{};
+    replies.reserve(payloads.size());
+    if constexpr (return_type_of(handler) == ^^void) {
+      (std::forward<Obj>(obj).[:handler:])(std::span<element_type>{calls});
+      if constexpr (is_oneway<Meta>) {
+        // empty messages are not sent, see BlockingCall::handle
+        replies.resize(payloads.size());
+      } else {
+        for (std::size_t idx = 0; idx < payloads.size(); ++idx) {
+          replies.push_back(respond());
+        }
+      }
+    } else {
+      static_assert(!is_oneway<Meta>, "Batch handlers of one-way methods must return void");
+      for (auto&& result : (std::forward<Obj>(obj).[:handler:])(std::span<element_type>{calls})) {
+        replies.push_back(respond(std::forward<decltype(result)>(result)));
+      }
+      if (replies.size() != payloads.size()) {
+        throw std::length_error("Batch handler must return one result per call");
+      }
+    }
+    return replies;
+  }
+
+  static CallInfo describe(std::span<char const> data, bool raw) {
+    if constexpr (concurrency == Concurrency::keyed) {
+      return {.concurrency = concurrency, .key = key_of(data, raw), .oneway = is_oneway<Meta>};
     } else {
-      return Protocol::make_response(Idx, eval(std::forward<Obj>(obj), data));
+      return {.concurrency = concurrency, .oneway = is_oneway<Meta>};
     }
   }
+
+  // hash of the encoded key argument, equal values encode to equal bytes
+  static std::size_t key_of(std::span<char const> data, bool raw) {
+    constexpr auto key = key_parameter<Meta>();
+    static_assert(key < parameters_of(Meta).size(), "rpc::keyed does not name a parameter");
+    using key_type = [:remove_cvref(type_of(parameters_of(Meta)[key])):];
+
+    auto bytes = std::span<char const>{};
+    if (raw) {
+      check_raw(data);
+      bytes = data.subspan(raw_offsets[key], sizeof(key_type));
+    } else {
+      auto args = Protocol::reader(data);
+      [:meta::expand(parameters_of(Meta)):] >> [&]<auto... Params> {
+        // skip preceding arguments
+        [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+          (erl::deserialize<[:type_of(Params...[Is]):]>(args), ...);
+        }(std::make_index_sequence<key>{});
+      };
+
+      auto before = args.remaining();
+      erl::deserialize<key_type>(args);
+      bytes = before.first(before.size() - args.remaining().size());
+    }
+
+    auto hasher = util::FNV1a{};
+    hasher(bytes.data(), bytes.size());
+    return hasher.finalize();
+  }
 };
 
 template <typename Service, int Idx, typename Super, typename R, std::meta::info H>
@@ -85,12 +336,14 @@ struct CustomProxy {
     // this assumes the only template arguments are a trailing pack
     constexpr static auto non_template_args = parameters_of(substitute(H, {})).size();
     auto message = [:substitute(H, std::vector{^^Ts...} | std::views::drop(non_template_args)):](std::forward<Ts>(args)...);
-    return handler->template call<Service, R>(Idx, message);
+    return handler->template call<Service, R>(opcode_of(H), message);
   }
 };
 
-template <auto H, int Idx, typename Protocol>
+template <auto H, std::uint32_t Opcode, typename Protocol>
 struct CustomDispatcher {
+  constexpr static std::uint32_t opcode = Opcode;
+
   template <typename Obj>
   static constexpr decltype(auto) eval(Obj&& obj, std::span<char const> data) {
     return (std::forward<Obj>(obj).[:H:])(data);
@@ -98,11 +351,12 @@ struct CustomDispatcher {
 
   template <typename Obj>
   static constexpr Protocol::message_type dispatch(Obj&& obj, std::span<char const> data) {
+    using service = std::remove_cvref_t<Obj>;
     if constexpr (return_type_of(H) == ^^void) {
       eval(std::forward<Obj>(obj), data);
-      return Protocol::make_response(Idx);
+      return Protocol::template seal<service>(Protocol::make_response(Opcode));
     } else {
-      return Protocol::make_response(Idx, eval(std::forward<Obj>(obj), data));
+      return Protocol::template seal<service>(Protocol::make_response(Opcode, eval(std::forward<Obj>(obj), data)));
     }
   }
 };
@@ -118,7 +372,7 @@ struct FunctionTemplateProxy {
       static_assert(can_substitute(Meta, {^^Args...[Is]...}), "Invalid template callback");
 
       constexpr auto target = substitute(Meta, {^^Args...[Is]...});
-      auto reader           = erl::message::MessageView{data};
+      auto reader           = std::remove_const_t<S>::protocol::reader(data);
       return service.[:target:](deserialize<Args>(reader)...);
     };
   }
@@ -148,12 +402,14 @@ struct FunctionTemplateProxy {
     using S = [:is_const(Meta) ? add_const(parent_of(Meta)) : parent_of(Meta):];
 
     return handler->template call<std::remove_const_t<S>, R>(
-        Idx, &FunctionTemplateProxy::call<R, S, std::remove_cvref_t<Args>...>, std::forward<Args>(args)...);
+        opcode_of(Meta), &FunctionTemplateProxy::call<R, S, std::remove_cvref_t<Args>...>, std::forward<Args>(args)...);
   }
 };
 
-template <std::meta::info Meta, int Idx, typename Protocol>
+template <std::meta::info Meta, std::uint32_t Opcode, typename Protocol>
 struct FunctionTemplateDispatcher {
+  constexpr static std::uint32_t opcode = Opcode;
+
   using return_type  = [:[:meta::expand(parameters_of(substitute(Meta, {}))):] >> []<auto... Params> {
     return invoke_result(type_of(substitute(Meta, {})), {type_of(Params)...});
   }:];
@@ -165,27 +421,54 @@ struct FunctionTemplateDispatcher {
   static constexpr decltype(auto) eval(Obj&& obj, Deserializer auto& args) {
     fnc_type wrapper = deserialize<fnc_type>(args);
 
-    // TODO remove dependency on .buffer being a span
     // do not forward obj - wrapper expects a lvalue reference
-    return wrapper(obj, args.buffer.subspan(args.cursor));
+    return wrapper(obj, args.remaining());
   }
 
   template <typename Obj>
   static constexpr Protocol::message_type dispatch(Obj&& obj, std::span<char const> data) {
     constexpr auto base = substitute(Meta, {});
-    auto args           = message::MessageView{data};
+    auto args           = Protocol::reader(data);
 
     if constexpr (std::same_as<return_type, void>) {
       eval(std::forward<Obj>(obj), args);
-      return Protocol::make_response(Idx);
+      return Protocol::make_response(Opcode);
     } else {
-      return Protocol::make_response(Idx, eval(std::forward<Obj>(obj), args));
+      return Protocol::make_response(Opcode, eval(std::forward<Obj>(obj), args));
     }
   }
 };
 
+template <typename Service, typename Client>
+class Batch;
+
+template <typename Service, int Idx, typename Super>
+struct BatchProxy {
+  auto operator()() const {
+    // get a pointer to Proxy superobject from this subobject
+    constexpr static auto current_member = meta::get_nth_member(^^Super, Idx + 1);
+    Super* that = reinterpret_cast<Super*>(std::uintptr_t(this) - offset_of(current_member).bytes);
+
+    // first (unnamed) member of Proxy is a pointer to the actual handler
+    auto* handler = that->[:meta::get_nth_member(^^Super, 0):];
+    return Batch<Service, std::remove_pointer_t<decltype(handler)>>{handler};
+  }
+};
+
 template <typename... Ps>
 struct Policy {
+  // remote members in declaration order
+  template <typename Service>
+  consteval auto remote_members(this auto&& self) {
+    std::vector<std::meta::info> members{};
+    for (auto member_fnc : meta::named_members_of(^^Service)) {
+      if ((Ps::is_remote(member_fnc) || ...)) {
+        members.push_back(member_fnc);
+      }
+    }
+    return members;
+  }
+
   template <typename Service, typename Client>
   consteval auto make_proxy(this auto&& self, std::meta::info proxy) {
     std::vector args = {data_member_spec(^^Client*)};
@@ -200,19 +483,27 @@ struct Policy {
         args.push_back(member);
       }
     }
+
+    // remote.batch() collects calls until they are flushed, see rpc::Batch
+    // skipped if the service already has a member of that name
+    if (std::ranges::none_of(meta::named_members_of(^^Service),
+                             [](auto member) { return has_identifier(member) && identifier_of(member) == "batch"; })) {
+      auto idx = std::meta::reflect_value(static_cast<int>(args.size() - 1));
+      args.push_back(data_member_spec(substitute(^^BatchProxy, {^^Service, idx, proxy}),
+                                      {.name = "batch", .no_unique_address = true}));
+    }
     return args;
   }
 
   template <typename Service, typename Protocol>
   consteval auto make_dispatcher(this auto&& self) {
     std::vector<std::meta::info> args{};
-    int index = 0;
 
     for (auto member_fnc : meta::named_members_of(^^Service)) {
       std::meta::info member;
 
       if (((Ps::is_remote(member_fnc) && ((member = Ps::template make_dispatch_member<Service, Protocol>(
-                                               index++, member_fnc)) != std::meta::info{})) ||
+                                               opcode_of(member_fnc), member_fnc)) != std::meta::info{})) ||
            ...)) {
         args.push_back(member);
       }
@@ -228,13 +519,13 @@ struct DefaultPolicy : Policy<DefaultPolicy> {
   template <typename Service>
   consteval static std::meta::info make_proxy_member(std::meta::info proxy, int index, std::meta::info fnc) {
     auto idx  = std::meta::reflect_value(index);
-    auto type = substitute(^^FunctionProxy, {^^Service, idx, proxy, return_type_of(fnc)});
+    auto type = substitute(^^FunctionProxy, {^^Service, idx, proxy, return_type_of(fnc), reflect_value(fnc)});
     return data_member_spec(type, {.name = identifier_of(fnc), .no_unique_address=true});
   }
 
   template <typename Service, typename Protocol>
-  consteval static std::meta::info make_dispatch_member(int index, std::meta::info fnc) {
-    auto idx = std::meta::reflect_value(index);
+  consteval static std::meta::info make_dispatch_member(std::uint32_t opcode, std::meta::info fnc) {
+    auto idx = std::meta::reflect_value(opcode);
     return substitute(^^FunctionDispatcher, {reflect_value(fnc), idx, ^^Protocol});
   }
 };
@@ -258,8 +549,8 @@ struct InProcess : Policy<InProcess> {
   }
 
   template <typename Service, typename Protocol>
-  consteval static std::meta::info make_dispatch_member(int index, std::meta::info fnc) {
-    auto idx = std::meta::reflect_value(index);
+  consteval static std::meta::info make_dispatch_member(std::uint32_t opcode, std::meta::info fnc) {
+    auto idx = std::meta::reflect_value(opcode);
     return substitute(^^FunctionTemplateDispatcher, {reflect_value(fnc), idx, ^^Protocol});
   }
 };
@@ -301,7 +592,7 @@ struct Annotated : Policy<Annotated> {
       if (meta::has_annotation<annotations::Handler>(fnc)) {
         type = substitute(^^CustomProxy, {^^Service, idx, proxy, return_of(fnc), reflect_value(fnc)});
       } else {
-        type = substitute(^^FunctionProxy, {^^Service, idx, proxy, return_of(fnc)});
+        type = substitute(^^FunctionProxy, {^^Service, idx, proxy, return_of(fnc), reflect_value(fnc)});
       }
     } else {
       auto base = substitute(fnc, {});
@@ -316,8 +607,8 @@ struct Annotated : Policy<Annotated> {
   }
 
   template <typename Service, typename Protocol>
-  consteval static std::meta::info make_dispatch_member(int index, std::meta::info fnc) {
-    auto idx = std::meta::reflect_value(index);
+  consteval static std::meta::info make_dispatch_member(std::uint32_t opcode, std::meta::info fnc) {
+    auto idx = std::meta::reflect_value(opcode);
     if (is_function(fnc)) {
       if (auto handler = annotation_of_type<annotations::Handler>(fnc); handler) {
         return substitute(^^CustomDispatcher, {reflect_value(handler->fnc), idx, ^^Protocol});
@@ -343,20 +634,89 @@ consteval auto make_proxy_t() {
     define_aggregate(^^Proxy, policy.template make_proxy<Service, Client>(^^Proxy));
   }
   static_assert(is_type(^^Proxy), "Could not inject RPC proxy class");
+  static_assert(has_valid_opcodes(schema<Service>), "Opcode collision, pin one of the methods with rpc::opcode(n)");
   return ^^Proxy;
 }
 
 template <typename... Members>
 struct Dispatcher {
+  static_assert(_dispatch_impl::all_unique(std::array<std::uint32_t, sizeof...(Members)>{Members::opcode...}),
+                "Opcode collision, pin one of the methods with rpc::opcode(n)");
+  static_assert(((Members::opcode < opcode_limit) && ...), "Opcode out of range");
+  constexpr static auto lookup =
+      _dispatch_impl::PerfectHash<sizeof...(Members)>{std::array<std::uint32_t, sizeof...(Members)>{Members::opcode...}};
+
+  template <typename Visitor, typename T>
+  constexpr static auto dispatch(T&& obj, std::size_t opcode, std::span<char const> args) {
+    if constexpr (sizeof...(Members) == 0) {
+      throw std::out_of_range("Invalid opcode");
+    } else {
+      using table = _dispatch_impl::DispatchTable<lookup, Visitor, T, Members...>;
+      return table::dispatch(std::forward<T>(obj), static_cast<std::uint32_t>(opcode), args);
+    }
+  }
+
+  template <typename T>
+  constexpr static auto operator()(T&& obj, std::size_t opcode, std::span<char const> args) {
+    return dispatch<_dispatch_impl::Metered<_dispatch_impl::Call>>(std::forward<T>(obj), opcode, args);
+  }
+
+  template <typename T>
+  constexpr static auto raw(T&& obj, std::size_t opcode, std::span<char const> args) {
+    return dispatch<_dispatch_impl::Metered<_dispatch_impl::RawCall>>(std::forward<T>(obj), opcode, args);
+  }
+
+  template <typename T>
+  constexpr static auto stream(T&& obj, std::size_t opcode, std::span<char const> args) {
+    return dispatch<_dispatch_impl::Metered<_dispatch_impl::StreamCall>>(std::forward<T>(obj), opcode, args);
+  }
+
+  template <typename M>
+  consteval static bool batches() {
+    if constexpr (requires { M::batched; }) {
+      return M::batched;
+    } else {
+      return false;
+    }
+  }
+
+  // whether calls to opcode can be passed to a batch handler together, see rpc::batched
+  constexpr static bool is_batched(std::size_t opcode) { return ((batches<Members>() && Members::opcode == opcode) || ...); }
+
   template <typename T>
-  constexpr static auto operator()(T&& obj, std::size_t index, std::span<char const> args) {
-    static_assert(sizeof...(Members) <= 256, "Too many callbacks");
-    constexpr static int strategy_idx = sizeof...(Members) <= 4    ? 1
-                                        : sizeof...(Members) <= 16 ? 2
-                                        : sizeof...(Members) <= 64 ? 3
-                                                                   : 4;
-    using strategy                    = _dispatch_impl::DispatchStrategy<strategy_idx>;
-    return strategy::template dispatch<T, Members...>(std::forward<T>(obj), index, args);
+  static void dispatch_batch(T&& obj, std::size_t opcode, std::span<std::span<char const> const> payloads, bool raw,
+                             auto& replies) {
+    auto probe = Probe::start_call<std::remove_cvref_t<T>>(Side::server, static_cast<std::uint32_t>(opcode),
+                                                           payloads.size());
+    for (auto payload : payloads) {
+      probe.received(payload.size());
+    }
+
+    auto dispatched = ([&] {
+      if constexpr (batches<Members>()) {
+        if (Members::opcode == opcode) {
+          replies = Members::dispatch_batch(obj, payloads, raw);
+          return true;
+        }
+      }
+      return false;
+    }() || ...);
+
+    for (auto const& reply : replies) {
+      probe.sent(std::span<char const>{reply}.size());
+    }
+
+    if (!dispatched) {
+      throw std::out_of_range("Method has no batch handler");
+    }
+  }
+
+  template <typename T>
+  constexpr static CallInfo describe(T&& obj, std::size_t opcode, std::span<char const> args, bool raw) {
+    if (raw) {
+      return dispatch<_dispatch_impl::Describe<true>>(std::forward<T>(obj), opcode, args);
+    }
+    return dispatch<_dispatch_impl::Describe<false>>(std::forward<T>(obj), opcode, args);
   }
 };
 
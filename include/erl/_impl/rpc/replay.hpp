@@ -0,0 +1,82 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <type_traits>
+
+#include <erl/_impl/net/capture.hpp>
+#include "metrics.hpp"
+
+namespace erl::rpc {
+enum class ReplaySpeed : std::uint8_t { recorded, maximum };
+
+struct ReplayReport {
+  std::size_t calls       = 0;
+  std::size_t errors      = 0;
+  std::uint64_t bytes_in  = 0;
+  std::uint64_t bytes_out = 0;
+  std::chrono::nanoseconds elapsed{0};
+  std::array<std::uint64_t, Histogram::bucket_count> latency{};
+
+  [[nodiscard]] double calls_per_second() const {
+    return elapsed.count() == 0 ? 0.0 : double(calls) * 1e9 / double(elapsed.count());
+  }
+
+  [[nodiscard]] std::chrono::nanoseconds percentile(double fraction) const {
+    return rpc::percentile(latency, fraction);
+  }
+};
+
+// dispatches the recorded requests of a capture to service and measures how long every call takes
+// captures made on the client side contain the requests as sent messages, server side captures as received ones
+// replies are discarded, calls that throw are counted as errors
+// deadlines of recorded calls are dropped
+template <typename Service>
+ReplayReport replay(Service&& service, std::span<net::CapturedMessage const> capture,
+                    ReplaySpeed speed       = ReplaySpeed::maximum,
+                    net::Direction requests = net::Direction::sent) {
+  using clock    = std::chrono::steady_clock;
+  using protocol = typename std::remove_cvref_t<Service>::protocol;
+
+  auto report  = ReplayReport{};
+  auto latency = Histogram{};
+  auto start   = clock::now();
+  auto first   = capture.empty() ? std::chrono::nanoseconds{0} : capture.front().time;
+
+  for (auto const& message : capture) {
+    if (message.direction != requests) {
+      continue;
+    }
+
+    if (speed == ReplaySpeed::recorded) {
+      std::this_thread::sleep_until(start + (message.time - first));
+    }
+
+    // recorded deadlines have long passed, replayed calls must still run
+    auto request = std::span<char const>{message.data};
+    auto rebased = protocol::clear_deadline(request);
+    if (rebased) {
+      request = std::span<char const>{*rebased};
+    }
+
+    auto begin = clock::now();
+    try {
+      auto reply = protocol::dispatch(service, request);
+      report.bytes_out += std::span<char const>{reply}.size();
+    } catch (...) {
+      ++report.errors;
+    }
+    latency.record(clock::now() - begin);
+    report.bytes_in += message.data.size();
+    ++report.calls;
+  }
+
+  report.elapsed = clock::now() - start;
+  for (std::size_t bucket = 0; bucket < Histogram::bucket_count; ++bucket) {
+    report.latency[bucket] = latency.buckets[bucket].load(std::memory_order_relaxed);
+  }
+  return report;
+}
+}  // namespace erl::rpc
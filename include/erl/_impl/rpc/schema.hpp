@@ -0,0 +1,153 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <experimental/meta>
+
+#include <erl/reflect>
+#include <erl/_impl/util/hash.hpp>
+#include <erl/_impl/util/meta.hpp>
+#include "stream.hpp"
+
+namespace erl::rpc {
+namespace annotations {
+// pins the opcode of a method, use it to resolve opcode collisions
+// or to keep the opcode of a renamed method
+struct Opcode {
+  std::uint32_t value;
+};
+
+consteval Opcode opcode(std::uint32_t value) {
+  return {value};
+}
+
+// the caller does not wait for the call to complete and no reply is sent
+// only applicable to methods returning void
+struct OnewayTag {
+} constexpr inline oneway{};
+}  // namespace annotations
+
+template <std::meta::info Meta>
+constexpr inline bool is_oneway =
+    Meta != std::meta::info{} && meta::has_annotation<annotations::OnewayTag>(Meta);
+
+// opcodes occupy the lower 24 bits of the message index, the highest one is reserved for the handshake
+constexpr inline std::uint32_t opcode_limit = 0x00FF'FFFF;
+
+// wire opcode of a remote method
+// derived from its name and parameter types, so it does not depend on declaration order
+consteval std::uint32_t opcode_of(std::meta::info fnc) {
+  if (auto pinned = annotation_of_type<annotations::Opcode>(fnc); pinned) {
+    return pinned->value;
+  }
+
+  auto hasher = util::FNV1a{};
+  hasher(identifier_of(fnc));
+  if (is_function(fnc)) {
+    for (auto param : parameters_of(fnc)) {
+      hasher(display_string_of(type_of(param)));
+    }
+  } else {
+    hasher(display_string_of(fnc));
+  }
+
+  // fold to 24 bits
+  auto hash = hasher.finalize();
+  return static_cast<std::uint32_t>((hash ^ (hash >> 24) ^ (hash >> 48)) % opcode_limit);
+}
+
+namespace _schema_impl {
+template <typename T>
+consteval std::uint64_t type_fingerprint() {
+  using type  = std::remove_cvref_t<T>;
+  auto hasher = util::FNV1a{};
+  if constexpr (std::is_pointer_v<type>) {
+    // pointers are only meaningful in-process, don't look through them
+    hasher(display_string_of(^^type));
+  } else {
+    hasher(hash_type<type>());
+  }
+
+  // raw encoding additionally requires identical layout
+  hasher(sizeof(type));
+  hasher(alignof(type));
+  return hasher.finalize();
+}
+}  // namespace _schema_impl
+
+// structural fingerprint of a remote method: name, parameter and return types
+template <std::meta::info Meta>
+consteval std::uint64_t fingerprint_of() {
+  auto hasher = util::FNV1a{};
+  hasher(identifier_of(Meta));
+
+  if constexpr (is_function(Meta)) {
+    [:meta::expand(parameters_of(Meta)):] >> [&]<auto... Params> {
+      (hasher(_schema_impl::type_fingerprint<[:type_of(Params):]>()), ...);
+    };
+
+    if constexpr (is_generator(return_type_of(Meta))) {
+      // streamed, elements are sent in frames
+      using element_type = std::ranges::range_value_t<[:return_type_of(Meta):]>;
+      hasher("stream");
+      hasher(_schema_impl::type_fingerprint<element_type>());
+    } else if constexpr (return_type_of(Meta) != ^^void) {
+      hasher(_schema_impl::type_fingerprint<[:return_type_of(Meta):]>());
+    }
+  } else {
+    // function templates are only usable in-process
+    hasher(display_string_of(Meta));
+  }
+
+  if (meta::has_annotation<annotations::OnewayTag>(Meta)) {
+    // changes whether a reply is sent
+    hasher("oneway");
+  }
+
+  hasher(std::to_underlying(std::endian::native));
+  return hasher.finalize();
+}
+
+struct MethodSchema {
+  std::uint32_t opcode;
+  std::uint64_t fingerprint;
+};
+
+// fingerprints of all remote methods of Service sorted by opcode
+template <typename Service>
+constexpr inline auto schema =
+    [:meta::expand(typename Service::policy{}.template remote_members<Service>()):] >> []<auto... Methods> {
+      auto methods = std::array<MethodSchema, sizeof...(Methods)>{
+          MethodSchema{opcode_of(Methods), fingerprint_of<Methods>()}...};
+      std::ranges::sort(methods, {}, &MethodSchema::opcode);
+      return methods;
+    };
+
+// position of opcode in a sorted schema, or schema.size() if it is unknown
+constexpr std::size_t find_method(std::span<MethodSchema const> methods, std::uint32_t opcode) {
+  auto it = std::ranges::lower_bound(methods, opcode, {}, &MethodSchema::opcode);
+  if (it == methods.end() || it->opcode != opcode) {
+    return methods.size();
+  }
+  return static_cast<std::size_t>(it - methods.begin());
+}
+
+// opcodes of a sorted schema must be unique and must not collide with the handshake
+constexpr bool has_valid_opcodes(std::span<MethodSchema const> methods) {
+  return std::ranges::adjacent_find(methods, {}, &MethodSchema::opcode) == methods.end() &&
+         std::ranges::all_of(methods, [](auto const& method) { return method.opcode < opcode_limit; });
+}
+
+// arguments of methods whose parameters are all trivially copyable can be sent as raw bytes
+template <std::meta::info Meta>
+constexpr inline bool is_raw_capable = [:meta::expand(parameters_of(Meta)):] >> []<auto... Params> {
+  return (std::is_trivially_copyable_v<[:remove_cvref(type_of(Params)):]> && ...);
+};
+
+// what to do with calls to methods whose fingerprints differ between client and server
+enum class Mismatch : std::uint8_t { fallback, reject };
+}  // namespace erl::rpc
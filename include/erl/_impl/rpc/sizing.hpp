@@ -0,0 +1,102 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <experimental/meta>
+
+#include <erl/reflect>
+#include <erl/_impl/net/message/buffer.hpp>
+#include <erl/_impl/util/meta.hpp>
+#include "proxy.hpp"
+
+/* Message buffer sizing
+
+Requests of methods whose parameters all have a fixed size have an upper
+bound known at compile time. SizedBuffer<Service> picks the smallest inline
+capacity that holds all of them, so these requests never spill to the heap.
+Methods without a fixed size - function templates, custom handlers and
+methods with dynamically sized arguments - can state their typical size with
+rpc::size_hint. Larger requests reserve their exact size up front, see
+RPCProtocol::encode.
+
+Like erl::fixed_size_of, all sizes refer to the fixed encoding.
+*/
+
+namespace erl::rpc {
+// encoded size of a request to Meta including its index, dynamic_size if any argument has no fixed size
+template <std::meta::info Meta>
+consteval std::size_t request_size_of() {
+  return [:meta::expand(parameters_of(Meta)):] >> []<auto... Params> {
+    if constexpr ((is_fixed_size<[:type_of(Params):]> && ...)) {
+      return sizeof(std::uint32_t) + (fixed_size_of<[:type_of(Params):]> + ... + 0UZ);
+    } else {
+      return dynamic_size;
+    }
+  };
+}
+
+namespace annotations {
+// typical encoded size of the arguments of a method whose requests have no fixed size
+// function templates and custom handlers are only considered by SizedBuffer with a hint
+struct SizeHint {
+  std::size_t bytes;
+};
+
+consteval SizeHint size_hint(std::size_t bytes) {
+  return {bytes};
+}
+}  // namespace annotations
+
+namespace _sizing_impl {
+consteval std::size_t hint_of(std::meta::info member) {
+  // remote function templates can be called without template arguments
+  auto fnc = is_function(member) ? member : substitute(member, {});
+  if (auto hint = annotation_of_type<annotations::SizeHint>(fnc); hint) {
+    return hint->bytes;
+  }
+  return dynamic_size;
+}
+}  // namespace _sizing_impl
+
+// largest request of Service with a fixed size or a size hint, 0 if there is none
+template <typename Service>
+consteval std::size_t max_request_size() {
+  return [:meta::expand(typename Service::policy{}.template remote_members<Service>()):] >> []<auto... Methods> {
+    std::size_t size = 0;
+    (
+        [&] {
+          if constexpr (constexpr auto hint = _sizing_impl::hint_of(Methods); hint != dynamic_size) {
+            size = std::max(size, sizeof(std::uint32_t) + hint);
+          } else if constexpr (is_function(Methods) && !meta::has_annotation<annotations::Handler>(Methods)) {
+            if (constexpr auto bound = request_size_of<Methods>(); bound != dynamic_size) {
+              size = std::max(size, bound);
+            }
+          }
+        }(),
+        ...);
+    return size;
+  };
+}
+
+// inline capacity of a HybridBuffer holding every request counted by max_request_size
+// services without such requests keep the default capacity
+template <typename Service>
+consteval std::size_t inline_capacity_of() {
+  constexpr auto size = max_request_size<Service>();
+  if (size == 0) {
+    return std::hardware_destructive_interference_size - 4;
+  }
+  // the heap pointer is 8 byte aligned, smaller steps only add padding
+  return (size + 7) / 8 * 8;
+}
+
+// may be named inside of Service, the capacity is computed once the buffer is first used
+//
+//   struct Service {
+//     using message_type = rpc::SizedBuffer<Service>;
+//     using protocol     = rpc::RPCProtocol<message_type>;
+//   };
+template <typename Service>
+struct SizedBuffer : message::HybridBuffer<inline_capacity_of<Service>()> {};
+}  // namespace erl::rpc
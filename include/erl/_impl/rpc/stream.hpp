@@ -0,0 +1,316 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <generator>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <experimental/meta>
+
+#include <erl/_impl/util/meta.hpp>
+
+/* Streaming results
+
+Methods returning std::generator are streamed instead of being sent as a whole.
+The reply to the call carries the first window of elements. Further windows are
+only produced when the client asks for them, so at most one window of elements
+is buffered on either side:
+
+  client                      server
+    call(args...)       ->      generator is created, first window
+                        <-      StreamFrame{id, done, elements}
+    credit(id, window)  ->      next window
+                        <-      StreamFrame{id, done, elements}
+    ...
+    credit(id, 0)       ->      stream is closed early
+
+Open streams belong to the connection that opened them and are freed together
+with it, other connections cannot resume or close them. A connection keeps at
+most StreamTable::limit streams open, streams that idle longer than
+StreamTable::idle or are evicted to make room for new ones end with an error
+on their next credit.
+*/
+
+namespace erl::rpc {
+namespace annotations {
+// number of elements per frame of a streamed result
+struct Streaming {
+  std::uint32_t window;
+
+  consteval Streaming operator()(std::uint32_t window) const { return {window}; }
+};
+constexpr inline Streaming stream{256};
+}  // namespace annotations
+
+consteval bool is_generator(std::meta::info type) {
+  return has_template_arguments(type) && template_of(type) == ^^std::generator;
+}
+
+template <std::meta::info Meta>
+constexpr inline bool is_streaming =
+    Meta != std::meta::info{} && is_function(Meta) && is_generator(return_type_of(Meta));
+
+// window of a streaming method, the method annotation takes precedence over the service annotation
+template <typename Service, std::meta::info Meta>
+consteval std::uint32_t stream_window() {
+  if (auto method = annotation_of_type<annotations::Streaming>(Meta); method) {
+    return method->window != 0 ? method->window : 1;
+  }
+  if (auto service = annotation_of_type<annotations::Streaming>(^^Service); service) {
+    return service->window != 0 ? service->window : 1;
+  }
+  return annotations::stream.window;
+}
+
+template <typename T>
+struct StreamFrame {
+  std::uint64_t id;
+  bool done;
+  std::vector<T> elements;
+};
+
+// open streams of a single connection
+// streams of any method share the table, ids are only meaningful on the connection that opened them
+// copies start out empty, see rpc::BlockingCall
+class StreamTable {
+  using clock = std::chrono::steady_clock;
+
+  struct OpenStream {
+    clock::time_point used;
+    virtual ~OpenStream() = default;
+  };
+
+  template <typename Generator>
+  struct Cursor : OpenStream {
+    Generator generator;
+    std::ranges::iterator_t<Generator> position;
+
+    explicit Cursor(Generator generator) : generator(std::move(generator)), position(this->generator.begin()) {}
+  };
+
+  struct State {
+    std::mutex lock;
+    std::unordered_map<std::uint64_t, std::unique_ptr<OpenStream>> streams;
+    std::uint64_t next_id = 1;
+  };
+
+  std::unique_ptr<State> state = std::make_unique<State>();
+
+  template <typename Generator>
+  static auto advance(std::uint64_t id, Cursor<Generator>& cursor, std::uint32_t window) {
+    auto frame = StreamFrame<std::ranges::range_value_t<Generator>>{.id = id, .done = false, .elements = {}};
+    frame.elements.reserve(window);
+    while (frame.elements.size() < window && cursor.position != std::default_sentinel) {
+      frame.elements.push_back(*cursor.position);
+      ++cursor.position;
+    }
+    frame.done = cursor.position == std::default_sentinel;
+    return frame;
+  }
+
+  void drop_idle() {
+    auto now = clock::now();
+    std::erase_if(state->streams, [&](auto const& entry) { return now - entry.second->used > idle; });
+  }
+
+  // drops idle streams, then the least recently used ones until there is room for another
+  void make_room() {
+    drop_idle();
+    while (!state->streams.empty() && state->streams.size() >= limit) {
+      state->streams.erase(std::ranges::min_element(state->streams, {}, [](auto const& entry) {
+                             return entry.second->used;
+                           }));
+    }
+  }
+
+public:
+  // streams a connection may keep open at once
+  std::size_t limit = 64;
+  // streams that were not resumed for this long are closed
+  clock::duration idle = std::chrono::minutes{1};
+
+  StreamTable() = default;
+
+  StreamTable(StreamTable const& other) : limit(other.limit), idle(other.idle) {}
+  StreamTable& operator=(StreamTable const& other) {
+    if (this != &other) {
+      state = std::make_unique<State>();
+      limit = other.limit;
+      idle  = other.idle;
+    }
+    return *this;
+  }
+
+  StreamTable(StreamTable&&)            = default;
+  StreamTable& operator=(StreamTable&&) = default;
+
+  template <typename Generator>
+  auto open(Generator generator, std::uint32_t window) {
+    auto cursor = std::make_unique<Cursor<Generator>>(std::move(generator));
+
+    std::uint64_t id;
+    {
+      auto guard = std::lock_guard{state->lock};
+      id         = state->next_id++;
+    }
+
+    auto frame = advance(id, *cursor, window);
+    if (!frame.done) {
+      auto guard   = std::lock_guard{state->lock};
+      cursor->used = clock::now();
+      make_room();
+      state->streams.emplace(id, std::move(cursor));
+    }
+    return frame;
+  }
+
+  // continues a stream, a window of 0 closes it
+  // throws if the stream is unknown, it may have been closed for idling or to make room
+  template <typename Generator>
+  auto resume(std::uint64_t id, std::uint32_t window) {
+    using frame_type = StreamFrame<std::ranges::range_value_t<Generator>>;
+
+    typename decltype(State::streams)::node_type node;
+    {
+      // take the cursor out while producing, the generator runs without the lock held
+      auto guard = std::lock_guard{state->lock};
+      drop_idle();
+      node = state->streams.extract(id);
+    }
+
+    if (window == 0) {
+      return frame_type{.id = id, .done = true, .elements = {}};
+    }
+
+    auto* cursor = node.empty() ? nullptr : dynamic_cast<Cursor<Generator>*>(node.mapped().get());
+    if (cursor == nullptr) {
+      throw std::out_of_range("Unknown stream");
+    }
+
+    auto frame = advance(id, *cursor, window);
+    if (!frame.done) {
+      auto guard   = std::lock_guard{state->lock};
+      cursor->used = clock::now();
+      state->streams.insert(std::move(node));
+    }
+    return frame;
+  }
+
+  [[nodiscard]] std::size_t size() const {
+    auto guard = std::lock_guard{state->lock};
+    return state->streams.size();
+  }
+};
+
+namespace _stream_impl {
+inline thread_local StreamTable* current = nullptr;
+}
+
+// streamed results of calls handled by this thread belong to table while in scope
+class StreamScope {
+  StreamTable* previous;
+
+public:
+  explicit StreamScope(StreamTable& table) : previous(std::exchange(_stream_impl::current, &table)) {}
+  ~StreamScope() { _stream_impl::current = previous; }
+
+  StreamScope(StreamScope const&)            = delete;
+  StreamScope& operator=(StreamScope const&) = delete;
+};
+
+// streams of the connection whose call is being handled
+inline StreamTable& current_streams() {
+  if (_stream_impl::current == nullptr) {
+    // calls dispatched outside of any connection, for example replayed ones
+    thread_local StreamTable detached{};
+    return detached;
+  }
+  return *_stream_impl::current;
+}
+
+// input range over a streamed result, asks for the next window once the current one is consumed
+// closes the stream if it is destroyed before reaching the end
+template <typename Client, typename Protocol, typename T>
+class StreamRange {
+  Client* client;
+  std::uint32_t opcode;
+  std::uint32_t window;
+  StreamFrame<T> frame;
+  std::size_t position = 0;
+
+  void refill() {
+    while (position == frame.elements.size() && !frame.done) {
+      client->send(client->template tag<Protocol>(Protocol::request_credit(opcode, frame.id, window)));
+      auto response = client->template receive<Protocol>();
+      Protocol::read_response_into(opcode, std::span<char const>{response}, frame);
+      position = 0;
+    }
+  }
+
+public:
+  class iterator {
+    StreamRange* range = nullptr;
+
+  public:
+    using value_type      = T;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() = default;
+    explicit iterator(StreamRange* range) : range(range) {}
+
+    T& operator*() const { return range->frame.elements[range->position]; }
+
+    iterator& operator++() {
+      ++range->position;
+      range->refill();
+      return *this;
+    }
+    void operator++(int) { ++*this; }
+
+    friend bool operator==(iterator const& self, std::default_sentinel_t) {
+      return self.range->position == self.range->frame.elements.size() && self.range->frame.done;
+    }
+  };
+
+  StreamRange(Client* client, std::uint32_t opcode, std::uint32_t window, StreamFrame<T> first)
+      : client(client)
+      , opcode(opcode)
+      , window(window)
+      , frame(std::move(first)) {}
+
+  StreamRange(StreamRange const&)            = delete;
+  StreamRange& operator=(StreamRange const&) = delete;
+
+  StreamRange(StreamRange&& other) noexcept
+      : client(std::exchange(other.client, nullptr))
+      , opcode(other.opcode)
+      , window(other.window)
+      , frame(std::move(other.frame))
+      , position(other.position) {}
+
+  ~StreamRange() {
+    if (client == nullptr || frame.done) {
+      return;
+    }
+
+    try {
+      client->send(client->template tag<Protocol>(Protocol::request_credit(opcode, frame.id, 0), {}));
+      client->template receive<Protocol>({});
+    } catch (...) {
+      // the connection is gone, nothing left to close
+    }
+  }
+
+  iterator begin() {
+    refill();
+    return iterator{this};
+  }
+  std::default_sentinel_t end() const { return {}; }
+};
+}  // namespace erl::rpc
@@ -0,0 +1,190 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+/* LZ77 block compression
+
+Dependency-free block compressor using the LZ4 block layout. Every sequence is
+
+  [token] [literal length...] [literals] [offset (2 bytes LE)] [match length...]
+
+The high nibble of the token holds the literal length, the low nibble the match
+length minus 4. A nibble of 15 is followed by extension bytes that are summed
+until one of them is not 255. The final sequence consists of literals only.
+*/
+
+namespace erl::util::lz {
+namespace _lz_impl {
+constexpr inline std::size_t min_match   = 4;
+constexpr inline std::size_t hash_log    = 12;
+constexpr inline std::size_t max_offset  = 0xFFFF;
+// matches may not extend into the last bytes of the input
+constexpr inline std::size_t last_literals = 5;
+constexpr inline std::size_t match_limit   = 12;
+
+inline std::uint32_t read32(char const* data) {
+  std::uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+inline std::uint32_t hash(std::uint32_t sequence) {
+  return (sequence * 2654435761U) >> (32 - hash_log);
+}
+
+inline char* write_length(char* out, std::size_t length) {
+  while (length >= 255) {
+    *out++ = static_cast<char>(255);
+    length -= 255;
+  }
+  *out++ = static_cast<char>(length);
+  return out;
+}
+
+inline char* write_sequence(char* out, char const* literals, std::size_t literal_length, std::size_t offset,
+                            std::size_t match_length) {
+  auto* token = out++;
+  auto literal_nibble = literal_length < 15 ? literal_length : 15;
+  if (literal_length >= 15) {
+    out = write_length(out, literal_length - 15);
+  }
+  std::memcpy(out, literals, literal_length);
+  out += literal_length;
+
+  std::size_t match_nibble = 0;
+  if (offset != 0) {
+    *out++ = static_cast<char>(offset & 0xFF);
+    *out++ = static_cast<char>(offset >> 8);
+
+    auto length  = match_length - min_match;
+    match_nibble = length < 15 ? length : 15;
+    if (length >= 15) {
+      out = write_length(out, length - 15);
+    }
+  }
+
+  *token = static_cast<char>(literal_nibble << 4 | match_nibble);
+  return out;
+}
+
+inline bool read_length(std::span<char const> input, std::size_t& cursor, std::size_t& length) {
+  unsigned char current = 0;
+  do {
+    if (cursor >= input.size()) {
+      return false;
+    }
+    current = static_cast<unsigned char>(input[cursor++]);
+    length += current;
+  } while (current == 255);
+  return true;
+}
+}  // namespace _lz_impl
+
+// worst case output size for an input of `size` bytes
+constexpr std::size_t compress_bound(std::size_t size) {
+  return size + size / 255 + 16;
+}
+
+// compresses `input` into `output`, which must hold at least compress_bound(input.size()) bytes
+// returns the compressed size
+inline std::size_t compress(std::span<char const> input, char* output) {
+  using namespace _lz_impl;
+  std::uint32_t table[1U << hash_log]{};
+
+  char const* base   = input.data();
+  std::size_t size   = input.size();
+  std::size_t cursor = 0;
+  std::size_t anchor = 0;
+  char* out          = output;
+
+  if (size > match_limit) {
+    auto const limit = size - match_limit;
+    while (cursor < limit) {
+      auto sequence = read32(base + cursor);
+      auto& slot    = table[hash(sequence)];
+      // slots store position + 1, 0 marks an empty slot
+      std::size_t candidate = slot;
+      slot                  = static_cast<std::uint32_t>(cursor + 1);
+
+      if (candidate == 0 || cursor - (candidate - 1) > max_offset || read32(base + candidate - 1) != sequence) {
+        ++cursor;
+        continue;
+      }
+
+      auto match  = candidate - 1;
+      auto length = min_match;
+      while (cursor + length < size - last_literals && base[match + length] == base[cursor + length]) {
+        ++length;
+      }
+
+      out    = write_sequence(out, base + anchor, cursor - anchor, cursor - match, length);
+      cursor += length;
+      anchor = cursor;
+    }
+  }
+
+  out = write_sequence(out, base + anchor, size - anchor, 0, 0);
+  return static_cast<std::size_t>(out - output);
+}
+
+// upper bound of the original size of a compressed block
+// every input byte expands to at most 255 output bytes, larger claims are malformed
+constexpr std::size_t max_decompressed_size(std::size_t compressed_size) {
+  return compressed_size * 255 + 16;
+}
+
+// decompresses `input` into `output`, which must be exactly as large as the original data
+// returns false if the input is malformed
+inline bool decompress(std::span<char const> input, std::span<char> output) {
+  using namespace _lz_impl;
+  std::size_t cursor  = 0;
+  std::size_t written = 0;
+
+  while (cursor < input.size()) {
+    auto token = static_cast<unsigned char>(input[cursor++]);
+
+    std::size_t literal_length = token >> 4;
+    if (literal_length == 15 && !read_length(input, cursor, literal_length)) {
+      return false;
+    }
+    if (cursor + literal_length > input.size() || written + literal_length > output.size()) {
+      return false;
+    }
+    std::memcpy(output.data() + written, input.data() + cursor, literal_length);
+    cursor += literal_length;
+    written += literal_length;
+
+    if (cursor == input.size()) {
+      // last sequence has no match
+      break;
+    }
+
+    if (cursor + 2 > input.size()) {
+      return false;
+    }
+    std::size_t offset = static_cast<unsigned char>(input[cursor]) |
+                         static_cast<std::size_t>(static_cast<unsigned char>(input[cursor + 1])) << 8;
+    cursor += 2;
+    if (offset == 0 || offset > written) {
+      return false;
+    }
+
+    std::size_t match_length = token & 0x0F;
+    if (match_length == 15 && !read_length(input, cursor, match_length)) {
+      return false;
+    }
+    match_length += min_match;
+    if (written + match_length > output.size()) {
+      return false;
+    }
+
+    // source and destination may overlap, copy byte by byte
+    for (std::size_t idx = 0; idx < match_length; ++idx) {
+      output[written + idx] = output[written - offset + idx];
+    }
+    written += match_length;
+  }
+  return written == output.size();
+}
+}  // namespace erl::util::lz
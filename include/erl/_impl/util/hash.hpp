@@ -42,6 +42,14 @@ public:
     }
   }
 
+  // hashes the little-endian byte representation of value
+  constexpr void operator()(std::integral auto value) {
+    for (std::size_t idx = 0; idx < sizeof(value); ++idx) {
+      state ^= static_cast<std::uint64_t>((value >> (idx * 8)) & 0xFF);
+      state *= 0x100000001b3ULL;
+    }
+  }
+
   [[nodiscard]] constexpr std::size_t finalize() const { return state; }
 };
 
@@ -0,0 +1,82 @@
+#include <string>
+#include <string_view>
+
+#if (defined(_WIN32) || defined(_WIN64))
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#    include <Windows.h>
+#    undef WIN32_LEAN_AND_MEAN
+#  else
+#    include <Windows.h>
+#  endif
+#else
+#  include <cerrno>
+#  include <cstring>
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#include <erl/records>
+
+namespace erl::platform {
+MappedFile map_file(std::string_view path) {
+  auto name = std::string{path};
+#if (defined(_WIN32) || defined(_WIN64))
+  HANDLE file = ::CreateFileA(name.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    throw RecordError("Could not open " + name);
+  }
+
+  LARGE_INTEGER size;
+  if (!::GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    ::CloseHandle(file);
+    throw RecordError("Could not map " + name);
+  }
+
+  HANDLE mapping = ::CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  ::CloseHandle(file);
+  if (mapping == NULL) {
+    throw RecordError("Could not map " + name);
+  }
+
+  void* data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (data == NULL) {
+    ::CloseHandle(mapping);
+    throw RecordError("Could not map " + name);
+  }
+  return {static_cast<char const*>(data), static_cast<std::size_t>(size.QuadPart), mapping};
+#else
+  int fd = ::open(name.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw RecordError("Could not open " + name + ": " + std::strerror(errno));
+  }
+
+  struct stat info{};
+  if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+    ::close(fd);
+    throw RecordError("Could not map " + name);
+  }
+
+  auto size  = static_cast<std::size_t>(info.st_size);
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  // the mapping keeps the file alive
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    throw RecordError("Could not map " + name + ": " + std::strerror(errno));
+  }
+  return {static_cast<char const*>(data), size, nullptr};
+#endif
+}
+
+void unmap_file(MappedFile const& file) {
+#if (defined(_WIN32) || defined(_WIN64))
+  ::UnmapViewOfFile(file.data);
+  ::CloseHandle(file.handle);
+#else
+  ::munmap(const_cast<char*>(file.data), file.size);
+#endif
+}
+}  // namespace erl::platform
@@ -0,0 +1,226 @@
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if (defined(_WIN32) || defined(_WIN64))
+#else
+#  include <cerrno>
+#  include <csignal>
+#  include <sys/socket.h>
+#  include <sys/types.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+#include <erl/_impl/net/process.hpp>
+
+namespace erl::platform {
+#if !(defined(_WIN32) || defined(_WIN64))
+namespace {
+bool send_all(int connection, char const* data, std::size_t size) {
+  while (size != 0) {
+    auto amount = ::send(connection, data, size, MSG_NOSIGNAL);
+    if (amount < 0 && errno == EINTR) {
+      continue;
+    }
+    if (amount <= 0) {
+      return false;
+    }
+    data += amount;
+    size -= static_cast<std::size_t>(amount);
+  }
+  return true;
+}
+
+bool receive_all(int connection, char* data, std::size_t size) {
+  while (size != 0) {
+    auto amount = ::recv(connection, data, size, 0);
+    if (amount < 0 && errno == EINTR) {
+      continue;
+    }
+    if (amount <= 0) {
+      return false;
+    }
+    data += amount;
+    size -= static_cast<std::size_t>(amount);
+  }
+  return true;
+}
+
+void close_connection(Process& process) {
+  if (process.connection >= 0) {
+    ::close(process.connection);
+    process.connection = -1;
+  }
+}
+
+// passes the id of a new worker and the parent end of its socket, a negative id reports failure
+bool send_worker(int control, std::int64_t id, int connection) {
+  alignas(cmsghdr) char control_buffer[CMSG_SPACE(sizeof(int))]{};
+  iovec payload{&id, sizeof(id)};
+  msghdr message{};
+  message.msg_iov    = &payload;
+  message.msg_iovlen = 1;
+  if (connection >= 0) {
+    message.msg_control    = control_buffer;
+    message.msg_controllen = sizeof(control_buffer);
+    auto* header           = CMSG_FIRSTHDR(&message);
+    header->cmsg_level     = SOL_SOCKET;
+    header->cmsg_type      = SCM_RIGHTS;
+    header->cmsg_len       = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(header), &connection, sizeof(int));
+  }
+
+  while (true) {
+    auto amount = ::sendmsg(control, &message, MSG_NOSIGNAL);
+    if (amount < 0 && errno == EINTR) {
+      continue;
+    }
+    return amount == sizeof(id);
+  }
+}
+
+Process receive_worker(int control) {
+  auto worker = Process{};
+  alignas(cmsghdr) char control_buffer[CMSG_SPACE(sizeof(int))]{};
+  iovec payload{&worker.id, sizeof(worker.id)};
+  msghdr message{};
+  message.msg_iov        = &payload;
+  message.msg_iovlen     = 1;
+  message.msg_control    = control_buffer;
+  message.msg_controllen = sizeof(control_buffer);
+
+  ssize_t amount;
+  do {
+    amount = ::recvmsg(control, &message, MSG_CMSG_CLOEXEC);
+  } while (amount < 0 && errno == EINTR);
+
+  auto* header = CMSG_FIRSTHDR(&message);
+  if (header != nullptr && header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+    std::memcpy(&worker.connection, CMSG_DATA(header), sizeof(int));
+  }
+
+  if (amount != sizeof(worker.id) || worker.id <= 0 || worker.connection < 0) {
+    close_connection(worker);
+    throw ProcessError("Could not spawn worker");
+  }
+  return worker;
+}
+
+[[noreturn]] void run_spawner(int control, std::function<void(int)> const& worker) {
+  // workers are reaped automatically
+  ::signal(SIGCHLD, SIG_IGN);
+
+  char request;
+  while (receive_all(control, &request, sizeof(request))) {
+    int ends[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, ends) != 0) {
+      send_worker(control, -1, -1);
+      continue;
+    }
+
+    auto id = ::fork();
+    if (id == 0) {
+      ::close(control);
+      ::close(ends[0]);
+      ::signal(SIGCHLD, SIG_DFL);
+
+      int status = 0;
+      try {
+        worker(ends[1]);
+      } catch (...) {
+        status = 1;
+      }
+      ::_exit(status);
+    }
+
+    ::close(ends[1]);
+    send_worker(control, id < 0 ? -1 : id, id < 0 ? -1 : ends[0]);
+    ::close(ends[0]);
+  }
+  ::_exit(0);
+}
+}  // namespace
+#endif
+
+Process spawn_spawner(std::function<void(int)> const& worker) {
+#if (defined(_WIN32) || defined(_WIN64))
+  throw ProcessError("Worker processes are not supported on this platform");
+#else
+  int ends[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, ends) != 0) {
+    throw ProcessError(std::string("Could not create socket: ") + std::strerror(errno));
+  }
+
+  auto id = ::fork();
+  if (id < 0) {
+    auto error = errno;
+    ::close(ends[0]);
+    ::close(ends[1]);
+    throw ProcessError(std::string("Could not fork: ") + std::strerror(error));
+  }
+
+  if (id == 0) {
+    ::close(ends[0]);
+    // skips the parent's atexit handlers and static destructors
+    run_spawner(ends[1], worker);
+  }
+
+  ::close(ends[1]);
+  return {id, ends[0]};
+#endif
+}
+
+void stop_spawner(Process& spawner) {
+#if !(defined(_WIN32) || defined(_WIN64))
+  close_connection(spawner);
+  if (spawner.id > 0) {
+    while (::waitpid(static_cast<pid_t>(spawner.id), nullptr, 0) < 0 && errno == EINTR) {
+    }
+    spawner.id = -1;
+  }
+#endif
+}
+
+Process spawn_worker(Process const& spawner) {
+#if (defined(_WIN32) || defined(_WIN64))
+  throw ProcessError("Worker processes are not supported on this platform");
+#else
+  char request = 1;
+  if (!send_all(spawner.connection, &request, sizeof(request))) {
+    throw ProcessError("Worker spawner is gone");
+  }
+  return receive_worker(spawner.connection);
+#endif
+}
+
+void stop_worker(Process& worker) {
+#if !(defined(_WIN32) || defined(_WIN64))
+  close_connection(worker);
+  worker.id = -1;
+#endif
+}
+
+bool send_frame(int connection, std::span<char const> message) {
+#if (defined(_WIN32) || defined(_WIN64))
+  return false;
+#else
+  auto size = static_cast<std::uint32_t>(message.size());
+  return send_all(connection, reinterpret_cast<char const*>(&size), sizeof(size)) &&
+         send_all(connection, message.data(), message.size());
+#endif
+}
+
+bool receive_frame(int connection, std::vector<char>& message) {
+#if (defined(_WIN32) || defined(_WIN64))
+  return false;
+#else
+  std::uint32_t size;
+  if (!receive_all(connection, reinterpret_cast<char*>(&size), sizeof(size))) {
+    return false;
+  }
+  message.resize(size);
+  return receive_all(connection, message.data(), size);
+#endif
+}
+}  // namespace erl::platform
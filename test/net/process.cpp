@@ -0,0 +1,105 @@
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <gtest/gtest.h>
+#include <erl/_impl/net/message/buffer.hpp>
+#include <erl/_impl/net/process.hpp>
+
+using Message = erl::message::HeapBuffer;
+
+namespace {
+// echoes every message, aborts on "crash"
+void echo(int connection) {
+  auto peer = erl::net::WorkerConnection<Message>{connection};
+  while (true) {
+    auto message = peer.recv();
+    if (message.size() == 0) {
+      return;
+    }
+    auto data = message.finalize();
+    if (std::string_view{data.data(), data.size()} == "crash") {
+      std::abort();
+    }
+    peer.send(message);
+  }
+}
+
+Message make_message(std::string_view text) {
+  auto message = Message{};
+  message.write(text.data(), text.size());
+  return message;
+}
+
+std::string call(erl::net::PoolClient<Message>& client, std::string_view text) {
+  client.send(make_message(text));
+  auto reply = client.recv();
+  client.release();
+  auto data = reply.finalize();
+  return {data.data(), data.size()};
+}
+}  // namespace
+
+TEST(Workers, EchoesThroughEveryWorker) {
+  auto workers = erl::net::Workers(3, echo);
+  EXPECT_EQ(workers.size(), 3);
+
+  auto client = erl::net::PoolClient<Message>{&workers};
+  for (int idx = 0; idx < 10; ++idx) {
+    auto text = "message " + std::to_string(idx);
+    EXPECT_EQ(call(client, text), text);
+  }
+}
+
+TEST(Workers, RestartsCrashedWorkers) {
+  // a single worker, leaked leases would block the next call
+  auto workers = erl::net::Workers(1, echo);
+  auto client  = erl::net::PoolClient<Message>{&workers};
+
+  client.send(make_message("crash"));
+  EXPECT_THROW(client.recv(), erl::ProcessError);
+  EXPECT_FALSE(client.lease.has_value());
+
+  EXPECT_EQ(call(client, "after crash"), "after crash");
+}
+
+TEST(Workers, RejectsReceiveWithoutCall) {
+  auto workers = erl::net::Workers(1, echo);
+  auto client  = erl::net::PoolClient<Message>{&workers};
+  EXPECT_THROW(client.recv(), std::logic_error);
+}
+
+TEST(PoolClient, DestructorReleasesLease) {
+  auto workers = erl::net::Workers(1, echo);
+  {
+    auto abandoned = erl::net::PoolClient<Message>{&workers};
+    abandoned.send(make_message("never received"));
+    EXPECT_TRUE(abandoned.lease.has_value());
+  }
+
+  // the reply of the abandoned call is still queued on the worker
+  auto client = erl::net::PoolClient<Message>{&workers};
+  client.send(make_message("next"));
+  auto stale = client.recv();
+  EXPECT_EQ(stale.size(), std::string_view{"never received"}.size());
+  client.release();
+}
+
+TEST(PoolClient, MovesTransferTheLease) {
+  auto workers = erl::net::Workers(1, echo);
+  auto first   = erl::net::PoolClient<Message>{&workers};
+  first.send(make_message("moved"));
+
+  auto second = std::move(first);
+  EXPECT_FALSE(first.lease.has_value());
+  ASSERT_TRUE(second.lease.has_value());
+
+  auto reply = second.recv();
+  EXPECT_EQ(reply.size(), std::string_view{"moved"}.size());
+  second.release();
+
+  auto third = erl::net::PoolClient<Message>{&workers};
+  third = std::move(second);
+  EXPECT_EQ(call(third, "reused"), "reused");
+}
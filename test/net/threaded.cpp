@@ -0,0 +1,117 @@
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+#include <erl/rpc>
+
+namespace {
+struct Calculator {
+  using policy       = erl::rpc::Annotated;
+  using message_type = erl::message::HeapBuffer;
+  using protocol     = erl::rpc::RPCProtocol<message_type>;
+
+  std::atomic<int> total{0};
+
+  [[= erl::rpc::callback]] int divide(int dividend, int divisor) {
+    if (divisor == 0) {
+      throw std::domain_error("Division by zero");
+    }
+    return dividend / divisor;
+  }
+
+  [[= erl::rpc::callback]] void fail() { throw 42; }
+
+  [[= erl::rpc::callback]] [[= erl::rpc::oneway]] void add(int value) {
+    if (value < 0) {
+      throw std::invalid_argument("Negative value");
+    }
+    total += value;
+  }
+
+  [[= erl::rpc::callback]] int sum() { return total; }
+};
+
+using Queue  = erl::queues::BoundedMPMC<Calculator::message_type, 64>;
+using Client = erl::rpc::BlockingCall<erl::net::QueueClient<Queue, Queue>>;
+
+struct ThreadedServer : testing::Test {
+  Queue requests{};
+  Queue replies{};
+  Calculator service{};
+  std::exception_ptr failure{};
+  std::jthread runner{};
+
+  Client client{{&requests, &replies}};
+
+  void SetUp() override {
+    runner = std::jthread([this] {
+      auto server = erl::net::ThreadedServer<Client>{Client{{&replies, &requests}}, 2};
+      try {
+        server.run(service);
+      } catch (...) {
+        failure = std::current_exception();
+      }
+    });
+  }
+
+  // closes the connection and waits for the server to return
+  void stop() {
+    if (runner.joinable()) {
+      client.kill();
+      runner.join();
+    }
+  }
+
+  void TearDown() override { stop(); }
+};
+}  // namespace
+
+TEST_F(ThreadedServer, AnswersCalls) {
+  auto remote = erl::rpc::make_proxy<Calculator>(&client);
+  for (int idx = 1; idx <= 10; ++idx) {
+    EXPECT_EQ(remote.divide(idx * 7, 7), idx);
+  }
+
+  stop();
+  EXPECT_FALSE(failure);
+}
+
+TEST_F(ThreadedServer, FailedCallsReplyWithError) {
+  auto remote = erl::rpc::make_proxy<Calculator>(&client);
+  try {
+    remote.divide(1, 0);
+    ADD_FAILURE() << "expected a RemoteError";
+  } catch (erl::rpc::RemoteError const& error) {
+    EXPECT_STREQ(error.what(), "Division by zero");
+  }
+
+  EXPECT_THROW(remote.fail(), erl::rpc::RemoteError);
+
+  // the connection remains usable
+  EXPECT_EQ(remote.divide(9, 3), 3);
+
+  // the first failure is rethrown once the server returns
+  stop();
+  ASSERT_TRUE(failure);
+  EXPECT_THROW(std::rethrow_exception(failure), std::domain_error);
+}
+
+TEST_F(ThreadedServer, FailedOneWayCallsSendNothing) {
+  auto remote = erl::rpc::make_proxy<Calculator>(&client);
+  remote.add(-1);
+  remote.add(5);
+
+  // would read an error reply to add(-1) if one was sent
+  int sum = 0;
+  for (int attempt = 0; attempt < 1000 && sum != 5; ++attempt) {
+    sum = remote.sum();
+  }
+  EXPECT_EQ(sum, 5);
+
+  stop();
+  ASSERT_TRUE(failure);
+  EXPECT_THROW(std::rethrow_exception(failure), std::invalid_argument);
+}
@@ -0,0 +1,125 @@
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <erl/records>
+
+namespace {
+struct Point {
+  float x;
+  float y;
+};
+
+struct Row {
+  std::uint32_t id;
+  Point position;
+  std::string name;
+  std::vector<std::int64_t> samples;
+  bool active;
+  std::vector<std::string> tags;
+};
+
+struct Other {
+  std::uint64_t id;
+};
+
+struct RecordFile : testing::Test {
+  std::string path = (std::filesystem::temp_directory_path() / "erl_records_test.rec").string();
+
+  void TearDown() override { std::filesystem::remove(path); }
+
+  void write_rows() const {
+    auto writer = erl::RecordWriter<Row>{};
+    writer.push({1, {0.5F, 1.5F}, "first", {1, 2, 3}, true, {}});
+    writer.push({2, {2.5F, 3.5F}, "second", {}, false, {"a", "b"}});
+    writer.write(path);
+  }
+
+  std::vector<char> read_file() const {
+    auto in = std::ifstream(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), {}};
+  }
+
+  void write_file(std::vector<char> const& data) const {
+    auto out = std::ofstream(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+  }
+
+  // points the name of the first record past the end of the variable-length section
+  void corrupt_name() const {
+    auto data   = read_file();
+    auto header = erl::_records_impl::Header{};
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    auto* entry = reinterpret_cast<erl::_records_impl::record_type<Row>*>(data.data() + header.records_offset);
+    entry->name = {header.heap_size, 1};
+    write_file(data);
+  }
+};
+}  // namespace
+
+TEST_F(RecordFile, RoundTrip) {
+  write_rows();
+  auto records = erl::MappedRecords<Row>(path);
+  ASSERT_EQ(records.size(), 2);
+  records.verify();
+
+  auto first = records[0];
+  EXPECT_EQ(first.get<^^Row::id>(), 1);
+  EXPECT_EQ(first.get<^^Row::position>().y, 1.5F);
+  EXPECT_EQ(first.get<^^Row::name>(), "first");
+  EXPECT_EQ(first.get<^^Row::samples>().size(), 3);
+  EXPECT_EQ(first.get<^^Row::samples>()[2], 3);
+  EXPECT_TRUE(first.get<^^Row::active>());
+  EXPECT_TRUE(first.get<^^Row::tags>().empty());
+
+  auto second = records[1].load();
+  EXPECT_EQ(second.id, 2);
+  EXPECT_EQ(second.name, "second");
+  EXPECT_TRUE(second.samples.empty());
+  EXPECT_FALSE(second.active);
+  EXPECT_EQ(second.tags, (std::vector<std::string>{"a", "b"}));
+}
+
+TEST_F(RecordFile, EmptyFile) {
+  erl::RecordWriter<Row>{}.write(path);
+  auto records = erl::MappedRecords<Row>(path);
+  EXPECT_TRUE(records.empty());
+}
+
+TEST_F(RecordFile, RejectsOtherRecordTypes) {
+  write_rows();
+  EXPECT_THROW(erl::MappedRecords<Other>(path), erl::RecordError);
+}
+
+TEST_F(RecordFile, RejectsTruncatedFiles) {
+  write_rows();
+  auto data = read_file();
+
+  data.resize(data.size() / 2);
+  write_file(data);
+  EXPECT_THROW(erl::MappedRecords<Row>(path), erl::RecordError);
+
+  data.resize(sizeof(erl::_records_impl::Header) - 1);
+  write_file(data);
+  EXPECT_THROW(erl::MappedRecords<Row>(path), erl::RecordError);
+}
+
+TEST_F(RecordFile, ChecksSlicesOnAccess) {
+  write_rows();
+  corrupt_name();
+
+  // opening only checks the header
+  auto records = erl::MappedRecords<Row>(path);
+  EXPECT_THROW(records[0].get<^^Row::name>(), erl::RecordError);
+  EXPECT_THROW(records[0].load(), erl::RecordError);
+  EXPECT_EQ(records[0].get<^^Row::id>(), 1);
+  EXPECT_EQ(records[1].get<^^Row::name>(), "second");
+
+  EXPECT_THROW(records.verify(), erl::RecordError);
+}
@@ -0,0 +1,102 @@
+#include <chrono>
+#include <span>
+#include <string_view>
+#include <thread>
+
+#include <gtest/gtest.h>
+#include <erl/_impl/rpc/cache.hpp>
+
+using erl::rpc::ResultCache;
+using erl::rpc::annotations::Cacheable;
+
+namespace {
+std::span<char const> bytes(std::string_view text) {
+  return {text.data(), text.size()};
+}
+
+std::string_view text_of(std::span<char const> data) {
+  return {data.data(), data.size()};
+}
+
+constexpr auto forever = Cacheable{0, 2};
+
+struct Service {};
+}  // namespace
+
+TEST(ResultCache, ReturnsStoredReplies) {
+  auto cache = ResultCache{};
+  EXPECT_FALSE(cache.find(1, bytes("request")));
+
+  cache.store(1, bytes("request"), bytes("reply"), forever);
+  auto hit = cache.find(1, bytes("request"));
+  ASSERT_TRUE(hit);
+  EXPECT_EQ(text_of(*hit), "reply");
+
+  // keyed on the opcode and the encoded request
+  EXPECT_FALSE(cache.find(2, bytes("request")));
+  EXPECT_FALSE(cache.find(1, bytes("other")));
+
+  cache.store(1, bytes("request"), bytes("newer"), forever);
+  EXPECT_EQ(text_of(*cache.find(1, bytes("request"))), "newer");
+}
+
+TEST(ResultCache, ExpiresEntries) {
+  auto cache = ResultCache{};
+  cache.store(1, bytes("request"), bytes("reply"), Cacheable{1, 2});
+  std::this_thread::sleep_for(std::chrono::milliseconds{5});
+  EXPECT_FALSE(cache.find(1, bytes("request")));
+}
+
+TEST(ResultCache, EvictsLeastRecentlyUsed) {
+  auto cache = ResultCache{};
+  cache.store(1, bytes("a"), bytes("1"), forever);
+  cache.store(1, bytes("b"), bytes("2"), forever);
+  // refreshes a, b is now the oldest entry
+  EXPECT_TRUE(cache.find(1, bytes("a")));
+
+  cache.store(1, bytes("c"), bytes("3"), forever);
+  EXPECT_TRUE(cache.find(1, bytes("a")));
+  EXPECT_FALSE(cache.find(1, bytes("b")));
+  EXPECT_TRUE(cache.find(1, bytes("c")));
+
+  // capacity is per method
+  cache.store(2, bytes("a"), bytes("4"), forever);
+  EXPECT_TRUE(cache.find(1, bytes("a")));
+}
+
+TEST(ResultCache, IgnoresMethodsWithoutCapacity) {
+  auto cache = ResultCache{};
+  cache.store(1, bytes("request"), bytes("reply"), Cacheable{0, 0});
+  EXPECT_FALSE(cache.find(1, bytes("request")));
+}
+
+TEST(ResultCache, DropsEntriesOnNewEpoch) {
+  auto cache = ResultCache{};
+  cache.store(1, bytes("request"), bytes("reply"), forever);
+  cache.observe(0);
+  EXPECT_TRUE(cache.find(1, bytes("request")));
+
+  cache.observe(1);
+  EXPECT_FALSE(cache.find(1, bytes("request")));
+}
+
+TEST(ResultCache, CopiesStartOutEmpty) {
+  auto cache = ResultCache{};
+  cache.observe(3);
+  cache.store(1, bytes("request"), bytes("reply"), forever);
+
+  auto copy = cache;
+  EXPECT_FALSE(copy.find(1, bytes("request")));
+  EXPECT_TRUE(cache.find(1, bytes("request")));
+
+  // the epoch is kept, observing it again does not drop new entries
+  copy.store(1, bytes("request"), bytes("reply"), forever);
+  copy.observe(3);
+  EXPECT_TRUE(copy.find(1, bytes("request")));
+}
+
+TEST(CacheEpoch, InvalidateAdvancesTheEpoch) {
+  auto before = erl::rpc::cache_epoch<Service>();
+  erl::rpc::invalidate<Service>();
+  EXPECT_EQ(erl::rpc::cache_epoch<Service>(), before + 1);
+}
@@ -0,0 +1,136 @@
+#include <chrono>
+#include <cstdint>
+#include <generator>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <erl/_impl/rpc/stream.hpp>
+
+using erl::rpc::StreamTable;
+
+namespace {
+using Numbers = std::generator<int>;
+
+Numbers count_to(int limit) {
+  for (int value = 0; value < limit; ++value) {
+    co_yield value;
+  }
+}
+
+std::vector<int> iota(int first, int last) {
+  auto values = std::vector<int>{};
+  for (int value = first; value < last; ++value) {
+    values.push_back(value);
+  }
+  return values;
+}
+}  // namespace
+
+TEST(StreamTable, ProducesWindows) {
+  auto table = StreamTable{};
+  auto frame = table.open(count_to(10), 4);
+  EXPECT_FALSE(frame.done);
+  EXPECT_EQ(frame.elements, iota(0, 4));
+  EXPECT_EQ(table.size(), 1);
+
+  auto next = table.resume<Numbers>(frame.id, 4);
+  EXPECT_EQ(next.id, frame.id);
+  EXPECT_FALSE(next.done);
+  EXPECT_EQ(next.elements, iota(4, 8));
+
+  auto last = table.resume<Numbers>(frame.id, 4);
+  EXPECT_TRUE(last.done);
+  EXPECT_EQ(last.elements, iota(8, 10));
+  EXPECT_EQ(table.size(), 0);
+}
+
+TEST(StreamTable, ShortStreamsAreNotKept) {
+  auto table = StreamTable{};
+  auto frame = table.open(count_to(3), 4);
+  EXPECT_TRUE(frame.done);
+  EXPECT_EQ(frame.elements, iota(0, 3));
+  EXPECT_EQ(table.size(), 0);
+  EXPECT_THROW(table.resume<Numbers>(frame.id, 4), std::out_of_range);
+}
+
+TEST(StreamTable, EmptyWindowCloses) {
+  auto table = StreamTable{};
+  auto frame = table.open(count_to(10), 2);
+
+  auto closed = table.resume<Numbers>(frame.id, 0);
+  EXPECT_TRUE(closed.done);
+  EXPECT_TRUE(closed.elements.empty());
+  EXPECT_EQ(table.size(), 0);
+  EXPECT_THROW(table.resume<Numbers>(frame.id, 2), std::out_of_range);
+}
+
+TEST(StreamTable, RejectsUnknownStreams) {
+  auto table = StreamTable{};
+  EXPECT_THROW(table.resume<Numbers>(42, 1), std::out_of_range);
+
+  // ids of one table mean nothing to another
+  auto frame = table.open(count_to(10), 2);
+  auto other = StreamTable{};
+  EXPECT_THROW(other.resume<Numbers>(frame.id, 2), std::out_of_range);
+
+  // nor may a stream be resumed as a different generator
+  EXPECT_THROW(table.resume<std::generator<long>>(frame.id, 2), std::out_of_range);
+}
+
+TEST(StreamTable, EvictsLeastRecentlyUsed) {
+  auto table  = StreamTable{};
+  table.limit = 2;
+
+  auto first  = table.open(count_to(10), 1);
+  auto second = table.open(count_to(10), 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds{1});
+  // first is now the most recently used one
+  table.resume<Numbers>(first.id, 1);
+
+  auto third = table.open(count_to(10), 1);
+  EXPECT_EQ(table.size(), 2);
+  EXPECT_THROW(table.resume<Numbers>(second.id, 1), std::out_of_range);
+  EXPECT_EQ(table.resume<Numbers>(first.id, 1).elements, iota(2, 3));
+  EXPECT_EQ(table.resume<Numbers>(third.id, 1).elements, iota(1, 2));
+}
+
+TEST(StreamTable, ClosesIdleStreams) {
+  auto table = StreamTable{};
+  table.idle = std::chrono::milliseconds{1};
+
+  auto frame = table.open(count_to(10), 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds{5});
+  EXPECT_THROW(table.resume<Numbers>(frame.id, 1), std::out_of_range);
+  EXPECT_EQ(table.size(), 0);
+}
+
+TEST(StreamTable, CopiesStartOutEmpty) {
+  auto table  = StreamTable{};
+  table.limit = 3;
+  table.open(count_to(10), 1);
+
+  auto copy = table;
+  EXPECT_EQ(copy.size(), 0);
+  EXPECT_EQ(copy.limit, 3);
+  EXPECT_EQ(table.size(), 1);
+}
+
+TEST(StreamScope, SelectsTheCurrentTable) {
+  auto& detached = erl::rpc::current_streams();
+
+  auto table = StreamTable{};
+  {
+    auto scope = erl::rpc::StreamScope{table};
+    EXPECT_EQ(&erl::rpc::current_streams(), &table);
+
+    auto nested = StreamTable{};
+    {
+      auto inner = erl::rpc::StreamScope{nested};
+      EXPECT_EQ(&erl::rpc::current_streams(), &nested);
+    }
+    EXPECT_EQ(&erl::rpc::current_streams(), &table);
+  }
+  EXPECT_EQ(&erl::rpc::current_streams(), &detached);
+}
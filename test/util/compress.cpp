@@ -0,0 +1,164 @@
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <erl/_impl/util/compress.hpp>
+
+namespace lz = erl::util::lz;
+
+namespace {
+std::vector<char> compress(std::string const& input) {
+  auto output = std::vector<char>(lz::compress_bound(input.size()));
+  output.resize(lz::compress(input, output.data()));
+  return output;
+}
+
+bool decompress(std::vector<char> const& input, std::string& output) {
+  return lz::decompress(input, output);
+}
+
+void expect_round_trip(std::string const& input) {
+  auto compressed = compress(input);
+  EXPECT_LE(compressed.size(), lz::compress_bound(input.size()));
+
+  auto output = std::string(input.size(), '\0');
+  ASSERT_TRUE(decompress(compressed, output));
+  EXPECT_EQ(output, input);
+}
+
+// deterministic bytes without long repetitions
+std::string noise(std::size_t size, std::uint32_t seed = 1) {
+  auto data = std::string(size, '\0');
+  for (auto& byte : data) {
+    seed = seed * 1664525U + 1013904223U;
+    byte = static_cast<char>(seed >> 24);
+  }
+  return data;
+}
+
+void append_length(std::vector<char>& out, std::size_t length) {
+  while (length >= 255) {
+    out.push_back(static_cast<char>(255));
+    length -= 255;
+  }
+  out.push_back(static_cast<char>(length));
+}
+}  // namespace
+
+TEST(Compress, Empty) {
+  auto compressed = compress("");
+  EXPECT_EQ(compressed.size(), 1);
+  expect_round_trip("");
+}
+
+TEST(Compress, ShortInputs) {
+  // inputs up to the match limit are stored as literals only
+  for (std::size_t size = 1; size <= 12; ++size) {
+    expect_round_trip(std::string(size, 'a'));
+    expect_round_trip(noise(size, size));
+  }
+  expect_round_trip("abcdabcdabcd");
+}
+
+TEST(Compress, LongRuns) {
+  auto run = std::string(100'000, 'x');
+  EXPECT_LT(compress(run).size(), 1'000);
+  expect_round_trip(run);
+
+  // literal and match lengths hitting the extension byte boundaries
+  for (std::size_t size : {14, 15, 19, 20, 254, 255, 256, 270, 271, 510, 511}) {
+    expect_round_trip(std::string(size, 'y'));
+    expect_round_trip(noise(size) + std::string(size, 'z') + noise(size, 7));
+  }
+}
+
+TEST(Compress, Incompressible) {
+  expect_round_trip(noise(1 << 16));
+}
+
+TEST(Compress, MaximumOffset) {
+  // repetitions right at and just beyond the largest offset
+  auto period = noise(0xFFFF, 3);
+  expect_round_trip(period + period + period);
+
+  auto beyond = noise(0x10000, 5);
+  expect_round_trip(beyond + beyond);
+}
+
+TEST(Decompress, MatchAtMaximumOffset) {
+  auto literals = noise(0xFFFF, 11);
+
+  auto block = std::vector<char>{static_cast<char>(0xF0)};
+  append_length(block, literals.size() - 15);
+  block.insert(block.end(), literals.begin(), literals.end());
+  block.push_back(static_cast<char>(0xFF));
+  block.push_back(static_cast<char>(0xFF));
+  // final literals-only sequence
+  block.push_back(0x10);
+  block.push_back('!');
+
+  auto output = std::string(literals.size() + 4 + 1, '\0');
+  ASSERT_TRUE(decompress(block, output));
+  EXPECT_EQ(output, literals + literals.substr(0, 4) + "!");
+}
+
+TEST(Decompress, RejectsTruncatedInput) {
+  auto input      = noise(300) + std::string(300, 'a');
+  auto compressed = compress(input);
+  auto output     = std::string(input.size(), '\0');
+
+  for (std::size_t size = 0; size < compressed.size(); ++size) {
+    auto truncated = std::vector<char>(compressed.begin(), compressed.begin() + size);
+    EXPECT_FALSE(decompress(truncated, output)) << "truncated to " << size << " bytes";
+  }
+}
+
+TEST(Decompress, RejectsTruncatedLengths) {
+  auto output = std::string(32, '\0');
+  // literal length extension missing
+  EXPECT_FALSE(decompress({static_cast<char>(0xF0)}, output));
+  // match length extension missing
+  EXPECT_FALSE(decompress({0x4F, 'a', 'b', 'c', 'd', 0x04, 0x00}, output));
+  // offset cut short
+  EXPECT_FALSE(decompress({0x40, 'a', 'b', 'c', 'd', 0x04}, output));
+}
+
+TEST(Decompress, RejectsBadOffsets) {
+  auto output = std::string(9, '\0');
+  // zero offset
+  EXPECT_FALSE(decompress({0x40, 'a', 'b', 'c', 'd', 0x00, 0x00, 0x10, 'e'}, output));
+  // offset reaching before the start of the output
+  EXPECT_FALSE(decompress({0x40, 'a', 'b', 'c', 'd', 0x05, 0x00, 0x10, 'e'}, output));
+  EXPECT_FALSE(decompress({0x40, 'a', 'b', 'c', 'd', static_cast<char>(0xFF), static_cast<char>(0xFF), 0x10, 'e'},
+                          output));
+
+  // the same block with a valid offset
+  EXPECT_TRUE(decompress({0x40, 'a', 'b', 'c', 'd', 0x04, 0x00, 0x10, 'e'}, output));
+  EXPECT_EQ(output, "abcdabcde");
+}
+
+TEST(Decompress, RejectsSizeMismatch) {
+  auto input      = noise(100) + std::string(100, 'b');
+  auto compressed = compress(input);
+
+  auto smaller = std::string(input.size() - 1, '\0');
+  EXPECT_FALSE(decompress(compressed, smaller));
+  auto larger = std::string(input.size() + 1, '\0');
+  EXPECT_FALSE(decompress(compressed, larger));
+
+  // literals and matches overflowing the output
+  auto output = std::string(3, '\0');
+  EXPECT_FALSE(decompress({0x40, 'a', 'b', 'c', 'd'}, output));
+  output = std::string(6, '\0');
+  EXPECT_FALSE(decompress({0x20, 'a', 'b', 0x02, 0x00, 0x10, 'e'}, output));
+}
+
+TEST(Decompress, RejectsEmptyInput) {
+  auto output = std::string(1, '\0');
+  EXPECT_FALSE(decompress({}, output));
+
+  auto empty = std::string{};
+  EXPECT_TRUE(decompress({}, empty));
+}